@@ -0,0 +1,114 @@
+// Construction, copy and composition (operator|) costs of the chains
+#include "../execution_chain/ExecutionChain.h"
+#include <benchmark/benchmark.h>
+#include <utility>
+
+namespace chain {
+
+namespace {
+
+struct Increment {
+    void operator()(long& a) const { ++a; }
+};
+
+// stateful : copied instead of shared when the chain is copied
+struct Count {
+    void operator()(long&) { ++count; }
+    long count = 0;
+};
+
+template <class Action>
+ExecutionChain<long&> MakeChain(long length)
+{
+    ExecutionChain<long&> chain;
+    for (long i = 0; i < length; ++i) {
+        chain |= Action{};
+    }
+    return chain;
+}
+
+template <class Action>
+void BM_Construct(benchmark::State& state)
+{
+    for (auto _ : state) {
+        ExecutionChain<long&> chain = MakeChain<Action>(state.range(0));
+        benchmark::DoNotOptimize(&chain);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ConstructBlockTuple(benchmark::State& state)
+{
+    for (auto _ : state) {
+        ExecutionChain<long&> chain = start_chain | Increment{} | Increment{} | Increment{} | Increment{}
+                                                  | Increment{} | Increment{} | Increment{} | Increment{};
+        benchmark::DoNotOptimize(&chain);
+    }
+}
+
+template <class Action>
+void BM_Copy(benchmark::State& state)
+{
+    const ExecutionChain<long&> chain = MakeChain<Action>(state.range(0));
+    for (auto _ : state) {
+        ExecutionChain<long&> copy = chain;
+        benchmark::DoNotOptimize(&copy);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Move(benchmark::State& state)
+{
+    ExecutionChain<long&> chain = MakeChain<Increment>(state.range(0));
+    for (auto _ : state) {
+        ExecutionChain<long&> moved = std::move(chain);
+        chain = std::move(moved);
+        benchmark::DoNotOptimize(&chain);
+    }
+}
+
+template <class Action>
+void BM_Compose(benchmark::State& state)
+{
+    const ExecutionChain<long&> lhs = MakeChain<Action>(state.range(0));
+    const ExecutionChain<long&> rhs = MakeChain<Action>(state.range(0));
+    for (auto _ : state) {
+        ExecutionChain<long&> composed = lhs | rhs;
+        benchmark::DoNotOptimize(&composed);
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+}
+
+void BM_ComposeRvalues(benchmark::State& state)
+{
+    for (auto _ : state) {
+        ExecutionChain<long&> composed = MakeChain<Increment>(state.range(0)) | MakeChain<Increment>(state.range(0));
+        benchmark::DoNotOptimize(&composed);
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+}
+
+void BM_Freeze(benchmark::State& state)
+{
+    const ExecutionChain<long&> chain = MakeChain<Increment>(state.range(0));
+    for (auto _ : state) {
+        auto frozen = chain.freeze();
+        benchmark::DoNotOptimize(&frozen);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Construct<Increment>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_Construct<Count>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_ConstructBlockTuple);
+BENCHMARK(BM_Copy<Increment>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_Copy<Count>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_Move)->Arg(40);
+BENCHMARK(BM_Compose<Increment>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_Compose<Count>)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_ComposeRvalues)->Arg(8)->Arg(40);
+BENCHMARK(BM_Freeze)->Arg(8)->Arg(40);
+
+} // namespace
+
+} // namespace chain
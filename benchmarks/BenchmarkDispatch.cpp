@@ -0,0 +1,188 @@
+// Dispatch overhead : a hand-written loop, a BlockTuple and an ExecutionChain running the same actions,
+// for several chain lengths, action sizes and argument counts.
+#include "../execution_chain/ExecutionChain.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace chain {
+
+namespace {
+
+// An action of Bytes bytes (at least 8), adding its first word to the argument
+template <std::size_t Bytes>
+struct Add {
+    static_assert(Bytes >= sizeof(long));
+
+    explicit Add(long value) { words[0] = value; }
+
+    void operator()(long& a) const { a += words[0]; }
+
+    std::array<long, Bytes / sizeof(long)> words{};
+};
+
+template <std::size_t Length, std::size_t Bytes>
+auto MakeBlockTuple()
+{
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return (start_chain | ... | Add<Bytes>(long(I) + 1));
+    }(std::make_index_sequence<Length>{});
+}
+
+// Each action is a block of its own
+template <std::size_t Length, std::size_t Bytes>
+ExecutionChain<long&> MakeExecutionChain()
+{
+    ExecutionChain<long&> chain;
+    for (std::size_t i = 0; i < Length; ++i) {
+        chain |= Add<Bytes>(long(i) + 1);
+    }
+    return chain;
+}
+
+template <std::size_t Length, std::size_t Bytes>
+void BM_HandWrittenLoop(benchmark::State& state)
+{
+    std::array<Add<Bytes>, Length> actions = [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<Add<Bytes>, Length>{ Add<Bytes>(long(I) + 1)... };
+    }(std::make_index_sequence<Length>{});
+    benchmark::DoNotOptimize(actions.data());
+
+    long value = 0;
+    for (auto _ : state) {
+        for (const auto& action : actions) {
+            action(value);
+        }
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * Length);
+}
+
+template <std::size_t Length, std::size_t Bytes>
+void BM_BlockTuple(benchmark::State& state)
+{
+    const auto blockTuple = MakeBlockTuple<Length, Bytes>();
+    long value = 0;
+    for (auto _ : state) {
+        blockTuple(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * Length);
+}
+
+template <std::size_t Length, std::size_t Bytes>
+void BM_ExecutionChain(benchmark::State& state)
+{
+    const ExecutionChain<long&> chain = MakeExecutionChain<Length, Bytes>();
+    long value = 0;
+    for (auto _ : state) {
+        chain(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * Length);
+}
+
+// A BlockTuple stored as a single block of an ExecutionChain
+template <std::size_t Length, std::size_t Bytes>
+void BM_ExecutionChainOfBlockTuple(benchmark::State& state)
+{
+    const ExecutionChain<long&> chain = MakeBlockTuple<Length, Bytes>();
+    long value = 0;
+    for (auto _ : state) {
+        chain(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * Length);
+}
+
+template <std::size_t Length, std::size_t Bytes>
+void BM_FrozenChain(benchmark::State& state)
+{
+    const auto frozen = MakeExecutionChain<Length, Bytes>().freeze();
+    long value = 0;
+    for (auto _ : state) {
+        frozen(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations() * Length);
+}
+
+#define CHAIN_DISPATCH_BENCHMARKS(Length, Bytes)                       \
+    BENCHMARK(BM_HandWrittenLoop<Length, Bytes>);                      \
+    BENCHMARK(BM_BlockTuple<Length, Bytes>);                           \
+    BENCHMARK(BM_ExecutionChain<Length, Bytes>);                       \
+    BENCHMARK(BM_ExecutionChainOfBlockTuple<Length, Bytes>);           \
+    BENCHMARK(BM_FrozenChain<Length, Bytes>)
+
+// chain lengths
+CHAIN_DISPATCH_BENCHMARKS(1, 8);
+CHAIN_DISPATCH_BENCHMARKS(8, 8);
+CHAIN_DISPATCH_BENCHMARKS(40, 8);
+
+// action sizes
+CHAIN_DISPATCH_BENCHMARKS(40, 64);
+CHAIN_DISPATCH_BENCHMARKS(40, 256);
+
+#undef CHAIN_DISPATCH_BENCHMARKS
+
+// argument counts : 8 blocks taking 1, 2 or 4 arguments
+
+void BM_HandWrittenLoop_Args4(benchmark::State& state)
+{
+    long a = 0, b = 0, c = 0, d = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < 8; ++i) {
+            a += 1; b += a; c += b; d += c;
+        }
+        benchmark::DoNotOptimize(d);
+    }
+}
+
+void BM_ExecutionChain_Args1(benchmark::State& state)
+{
+    ExecutionChain<long&> chain;
+    for (int i = 0; i < 8; ++i) {
+        chain |= [](long& a) { a += 1; };
+    }
+    long a = 0;
+    for (auto _ : state) {
+        chain(a);
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+void BM_ExecutionChain_Args2(benchmark::State& state)
+{
+    ExecutionChain<long&, long&> chain;
+    for (int i = 0; i < 8; ++i) {
+        chain |= [](long& a, long& b) { a += 1; b += a; };
+    }
+    long a = 0, b = 0;
+    for (auto _ : state) {
+        chain(a, b);
+        benchmark::DoNotOptimize(b);
+    }
+}
+
+void BM_ExecutionChain_Args4(benchmark::State& state)
+{
+    ExecutionChain<long&, long&, long&, long&> chain;
+    for (int i = 0; i < 8; ++i) {
+        chain |= [](long& a, long& b, long& c, long& d) { a += 1; b += a; c += b; d += c; };
+    }
+    long a = 0, b = 0, c = 0, d = 0;
+    for (auto _ : state) {
+        chain(a, b, c, d);
+        benchmark::DoNotOptimize(d);
+    }
+}
+
+BENCHMARK(BM_HandWrittenLoop_Args4);
+BENCHMARK(BM_ExecutionChain_Args1);
+BENCHMARK(BM_ExecutionChain_Args2);
+BENCHMARK(BM_ExecutionChain_Args4);
+
+} // namespace
+
+} // namespace chain
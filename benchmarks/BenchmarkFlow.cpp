@@ -0,0 +1,165 @@
+// If, Try, Switch and Repeat steps with predictable and unpredictable inputs
+#include "../execution_chain/ExecutionChain.h"
+#include "../execution_chain/ExecutionFlow.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+struct Context {
+    int input = 0;
+    long output = 0;
+};
+
+// 4096 inputs : all positive (predictable), or positive with a probability of 1/2 (unpredictable)
+std::vector<Context> MakeContexts(bool predictable)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(-100, 100);
+    std::vector<Context> contexts(4096);
+    for (auto& context : contexts) {
+        context.input = predictable ? 1 + (distribution(generator) & 63) : distribution(generator);
+    }
+    return contexts;
+}
+
+// 4096 inputs : cycling over 0..7 (predictable) or random in 0..7 (unpredictable)
+std::vector<Context> MakeKeys(bool predictable)
+{
+    std::mt19937 generator(42);
+    std::vector<Context> contexts(4096);
+    for (std::size_t i = 0; i < contexts.size(); ++i) {
+        contexts[i].input = predictable ? int(i % 8) : int(generator() % 8);
+    }
+    return contexts;
+}
+
+template <class ExecutableT>
+void RunOverContexts(benchmark::State& state, ExecutableT&& executable,
+                     std::vector<Context> (*makeContexts)(bool) = &MakeContexts)
+{
+    std::vector<Context> contexts = makeContexts(state.range(0) != 0);
+    for (auto _ : state) {
+        for (auto& context : contexts) {
+            executable(context);
+        }
+        benchmark::DoNotOptimize(contexts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * contexts.size());
+}
+
+void BM_HandWrittenIf(benchmark::State& state)
+{
+    RunOverContexts(state, [](Context& c) {
+        if (c.input > 0) { c.output += c.input; } else { c.output -= c.input; }
+    });
+}
+
+auto MakeIfThenElse()
+{
+    return If([](const Context& c) { return c.input > 0; })
+        .Then([](Context& c) { c.output += c.input; })
+        .Else([](Context& c) { c.output -= c.input; });
+}
+
+void BM_BlockTupleIf(benchmark::State& state)
+{
+    const auto blockTuple = start_chain | MakeIfThenElse();
+    RunOverContexts(state, blockTuple);
+}
+
+void BM_ExecutionChainIf(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain | MakeIfThenElse();
+    RunOverContexts(state, chain);
+}
+
+auto MakeTryFallback()
+{
+    return Try([](Context& c) { c.output += c.input; return c.input > 0; })
+        .Fallback([](Context& c) { c.output = 0; return true; });
+}
+
+void BM_BlockTupleTry(benchmark::State& state)
+{
+    // TryFallback is executed as non const
+    auto blockTuple = start_chain | MakeTryFallback();
+    RunOverContexts(state, blockTuple);
+}
+
+void BM_ExecutionChainTry(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain | MakeTryFallback();
+    RunOverContexts(state, chain);
+}
+
+// The If step over the whole batch : the predicate is evaluated into a mask, each branch runs over its lanes
+void BM_ExecutionChainBatchIf(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain | MakeIfThenElse();
+    std::vector<Context> contexts = MakeContexts(state.range(0) != 0);
+    for (auto _ : state) {
+        chain.ExecuteBatch(contexts);
+        benchmark::DoNotOptimize(contexts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * contexts.size());
+}
+
+// 8-way dispatch on the input : nested If steps against a Switch step (a jump table)
+template <int K>
+auto AddCase()
+{
+    return [](Context& c) { c.output += K; };
+}
+
+void BM_NestedIf8(benchmark::State& state)
+{
+    auto is = [](int k) { return [k](const Context& c) { return c.input == k; }; };
+    const ExecutionChain<Context&> chain = start_chain
+        | If(is(0)).Then(AddCase<0>()).Else(If(is(1)).Then(AddCase<1>()).Else(If(is(2)).Then(AddCase<2>())
+            .Else(If(is(3)).Then(AddCase<3>()).Else(If(is(4)).Then(AddCase<4>()).Else(If(is(5)).Then(AddCase<5>())
+            .Else(If(is(6)).Then(AddCase<6>()).Else(AddCase<7>())))))));
+    RunOverContexts(state, chain, &MakeKeys);
+}
+
+void BM_Switch8(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain
+        | Switch([](const Context& c) { return c.input; })
+            .Case<0>(AddCase<0>()).Case<1>(AddCase<1>()).Case<2>(AddCase<2>()).Case<3>(AddCase<3>())
+            .Case<4>(AddCase<4>()).Case<5>(AddCase<5>()).Case<6>(AddCase<6>()).Default(AddCase<7>());
+    RunOverContexts(state, chain, &MakeKeys);
+}
+
+// 8 repetitions of a step : unrolled at compile time against a run time count
+void BM_RepeatUnrolled8(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain | Repeat<8>([](Context& c) { c.output += c.input; });
+    RunOverContexts(state, chain);
+}
+
+void BM_RepeatLoop8(benchmark::State& state)
+{
+    const ExecutionChain<Context&> chain = start_chain | Repeat(8, [](Context& c) { c.output += c.input; });
+    RunOverContexts(state, chain);
+}
+
+// Arg(1) : predictable predicate, Arg(0) : unpredictable predicate
+BENCHMARK(BM_HandWrittenIf)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_BlockTupleIf)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_ExecutionChainIf)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_ExecutionChainBatchIf)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_BlockTupleTry)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_ExecutionChainTry)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_NestedIf8)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_Switch8)->ArgName("predictable")->Arg(1)->Arg(0);
+BENCHMARK(BM_RepeatUnrolled8)->ArgName("predictable")->Arg(1);
+BENCHMARK(BM_RepeatLoop8)->ArgName("predictable")->Arg(1);
+
+} // namespace
+
+} // namespace chain
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+// Define EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS to 1 (for the whole program) to reject, at compile time, the
+// actions taking by value an argument of the chain which is expensive to copy : `[](Race race) {}` copies the
+// whole race at each execution, where `[](Race& race) {}` was meant.
+// An argument is expensive to copy when it is not trivially copyable, or larger than
+// EXECUTION_CHAIN_MAX_COPIED_ARGUMENT_SIZE bytes (2 pointers by default).
+// Only the actions with a single operator() (or the functions) can be inspected : the generic lambdas and
+// the overloaded functors are always accepted.
+#ifndef EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS
+#define EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS 0
+#endif
+
+#ifndef EXECUTION_CHAIN_MAX_COPIED_ARGUMENT_SIZE
+#define EXECUTION_CHAIN_MAX_COPIED_ARGUMENT_SIZE (2 * sizeof(void*))
+#endif
+
+namespace chain
+{
+
+namespace detail
+{
+
+template<class... Ts>
+struct type_list {};
+
+// The parameters of a callable, when it has a single signature
+template<class F, class = void>
+struct parameters_of
+{
+    static constexpr bool known = false;
+};
+
+template<class R, class... Ps>
+struct parameters_of<R(Ps...), void>
+{
+    static constexpr bool known = true;
+    using type = type_list<Ps...>;
+};
+
+template<class R, class... Ps>
+struct parameters_of<R(Ps...) noexcept, void> : parameters_of<R(Ps...)> {};
+
+template<class R, class... Ps>
+struct parameters_of<R (*)(Ps...), void> : parameters_of<R(Ps...)> {};
+
+template<class R, class... Ps>
+struct parameters_of<R (*)(Ps...) noexcept, void> : parameters_of<R(Ps...)> {};
+
+template<class R, class C, class... Ps>
+struct parameters_of<R (C::*)(Ps...), void> : parameters_of<R(Ps...)> {};
+
+template<class R, class C, class... Ps>
+struct parameters_of<R (C::*)(Ps...) const, void> : parameters_of<R(Ps...)> {};
+
+template<class R, class C, class... Ps>
+struct parameters_of<R (C::*)(Ps...) noexcept, void> : parameters_of<R(Ps...)> {};
+
+template<class R, class C, class... Ps>
+struct parameters_of<R (C::*)(Ps...) const noexcept, void> : parameters_of<R(Ps...)> {};
+
+template<class F>
+struct parameters_of<F, std::enable_if_t<std::is_class_v<F>, std::void_t<decltype(&F::operator())>>>
+    : parameters_of<decltype(&F::operator())> {};
+
+template<class T>
+inline constexpr bool is_expensive_to_copy_v =
+    !std::is_trivially_copyable_v<T> || sizeof(T) > EXECUTION_CHAIN_MAX_COPIED_ARGUMENT_SIZE;
+
+// The parameter is a copy of the argument of the chain
+template<class Parameter, class Arg>
+inline constexpr bool is_copied_argument_v = !std::is_reference_v<Parameter>
+    && std::is_same_v<std::remove_cv_t<Parameter>, std::remove_cvref_t<Arg>>
+    && is_expensive_to_copy_v<std::remove_cv_t<Parameter>>;
+
+template<class... Args, class... Parameters>
+constexpr bool copies_any_of(type_list<Parameters...>)
+{
+    if constexpr (sizeof...(Parameters) == sizeof...(Args)) {
+        return (is_copied_argument_v<Parameters, Args> || ...);
+    }
+    else {
+        return false;
+    }
+}
+
+template<class Action, class... Args>
+constexpr bool copies_argument()
+{
+    using Parameters_t = parameters_of<std::remove_cvref_t<Action>>;
+    if constexpr (Parameters_t::known) {
+        return copies_any_of<Args...>(typename Parameters_t::type{});
+    }
+    else {
+        return false;
+    }
+}
+
+// True when the action takes an argument of the chain by value, and that argument is expensive to copy
+template<class Action, class... Args>
+inline constexpr bool copies_expensive_argument_v = copies_argument<Action, Args...>();
+
+// The actions copying an expensive argument are rejected when EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS is set
+template<class Action, class... Args>
+inline constexpr bool is_copy_accepted_v =
+    !EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS || !copies_expensive_argument_v<Action, Args...>;
+
+} // namespace detail
+
+} // namespace chain
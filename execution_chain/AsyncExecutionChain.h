@@ -0,0 +1,185 @@
+#pragma once
+
+#include "BlockArena.h"
+#include "ExecutionChain.h"
+#include "ExecutionPolicy.h"
+#include "Task.h"
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+// Executes every block of the chain
+template <class... Args>
+using AsyncExecutionChain = BasicAsyncExecutionChain<ExecutionPolicy::RunToEnd, Args...>;
+
+// Stops the execution at the first block returning (or completing with) false
+template <class... Args>
+using AsyncShortCircuitChain = BasicAsyncExecutionChain<ExecutionPolicy::ShortCircuit, Args...>;
+
+/**
+ * \brief An AsyncExecutionChain is an ExecutionChain whose actions may return awaitables, such as a Task. <br>
+ * Executing the chain returns a Task : awaiting it runs the blocks in order, and suspends at each
+ * asynchronous block until its awaitable completes.
+ * \code{.cpp}
+ *    AsyncExecutionChain<Request&> chain = start_chain
+ *        | [](Request& r) { r.Parse(); }                     // runs inline
+ *        | [](Request& r) -> Task<> { co_await r.Fetch(); }  // suspends the chain until fetched
+ *        | [](Request& r) { r.Reply(); };
+ *    co_await chain(request);  // within a coroutine
+ *    sync_wait(chain(request)); // or from a regular function
+ * \endcode
+ *
+ * \details Synchronous actions are called inline by the coroutine of the chain, without a coroutine frame
+ * of their own. An asynchronous action returning a Task<bool> is awaited as such, any other awaitable is
+ * awaited through an adapter Task. <br>
+ * The blocks of a BlockTuple are appended one by one, so that its asynchronous actions are awaited. <br>
+ * The chain and the arguments must outlive the execution : the task refers to both of them.
+*/
+template <class Policy, class... Args>
+class BasicAsyncExecutionChain
+{
+    // Exactly one of execute and execute_async is set, depending on the result of the action
+    struct DispatchEntry {
+        bool (*execute)(void*, Args&...);
+        Task<bool> (*execute_async)(void*, Args&...);
+        std::size_t offset;
+    };
+
+    template <class Action>
+    static bool ExecuteBlock(void* pBlock, Args&... args) {
+        return detail::Call(*static_cast<Action*>(pBlock), args...);
+    }
+
+    // The Task<bool> returned by the action is the task of the block
+    template <class Action>
+    static Task<bool> ForwardBlock(void* pBlock, Args&... args) {
+        return std::invoke(*static_cast<Action*>(pBlock), args...);
+    }
+
+    // Awaits the awaitable returned by the action, and results in its bool result or in true
+    template <class Action>
+    static Task<bool> AwaitBlock(void* pBlock, Args&... args) {
+        using Awaitable_t = std::invoke_result_t<Action&, Args&...>;
+        if constexpr (std::is_same_v<detail::await_result_t<Awaitable_t>, bool>) {
+            co_return co_await std::invoke(*static_cast<Action*>(pBlock), args...);
+        }
+        else {
+            co_await std::invoke(*static_cast<Action*>(pBlock), args...);
+            co_return true;
+        }
+    }
+
+public:
+    template <class ActionT>
+    using enable_if_action = std::enable_if_t<
+        !is_block_tuple_v<std::decay_t<ActionT>>
+        && !std::is_same_v<std::decay_t<ActionT>, BasicAsyncExecutionChain>
+        && std::is_invocable_v<std::decay_t<ActionT>&, Args&...>, bool>;
+
+    BasicAsyncExecutionChain() = default;
+
+    template <class ActionT, enable_if_action<ActionT> = true>
+    BasicAsyncExecutionChain(ActionT&& action)
+    {
+        append(std::forward<ActionT>(action));
+    }
+
+    template <class... ActionsT>
+    BasicAsyncExecutionChain(BlockTuple<ActionsT...> handler)
+    {
+        append(std::move(handler));
+    }
+
+    template <class ActionT, enable_if_action<ActionT> = true>
+    BasicAsyncExecutionChain& operator|=(ActionT&& action)
+    {
+        return append(std::forward<ActionT>(action));
+    }
+
+    template <class... ActionsT>
+    BasicAsyncExecutionChain& operator|=(BlockTuple<ActionsT...> handler)
+    {
+        return append(std::move(handler));
+    }
+
+    template <class ActionT, enable_if_action<ActionT> = true>
+    BasicAsyncExecutionChain& append(ActionT&& action)
+    {
+        using Action_t = std::decay_t<ActionT>;
+        using Result_t = std::invoke_result_t<Action_t&, Args&...>;
+
+        reserve_dispatch(m_dispatch.size() + 1);
+        const std::size_t offset = m_arena.template emplace<Action_t>(std::forward<ActionT>(action));
+        if constexpr (std::is_same_v<Result_t, Task<bool>>) {
+            m_dispatch.push_back({ nullptr, &ForwardBlock<Action_t>, offset });
+        }
+        else if constexpr (detail::is_awaitable_v<Result_t>) {
+            m_dispatch.push_back({ nullptr, &AwaitBlock<Action_t>, offset });
+        }
+        else {
+            m_dispatch.push_back({ &ExecuteBlock<Action_t>, nullptr, offset });
+        }
+        return *this;
+    }
+
+    // The actions of the BlockTuple are appended one by one
+    template <class... ActionsT>
+    BasicAsyncExecutionChain& append(BlockTuple<ActionsT...> handler)
+    {
+        std::apply([this](auto&&... actions) { (append(std::move(actions)), ...); }, std::move(handler.m_actions));
+        return *this;
+    }
+
+    // Executes the blocks in order, the task results in true if the chain ran to the end.
+    // With the ShortCircuit policy, the execution stops at the first block resulting in false.
+    Task<bool> Execute(Args&... args) const
+    {
+        for (const auto& entry : m_dispatch) {
+            void* const pBlock = m_arena.data() + entry.offset;
+            [[maybe_unused]] const bool result = entry.execute ? entry.execute(pBlock, args...)
+                                              : co_await entry.execute_async(pBlock, args...);
+            if constexpr (Policy::short_circuit) {
+                if (!result) {
+                    co_return false;
+                }
+            }
+        }
+        co_return true;
+    }
+
+    Task<bool> operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    // number of blocks of the chain
+    std::size_t size() const noexcept
+    {
+        return m_dispatch.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_dispatch.empty();
+    }
+
+private:
+    // Reserved before a block is placed in the arena, so that registering it cannot throw
+    void reserve_dispatch(std::size_t count)
+    {
+        if (count > m_dispatch.capacity()) {
+            m_dispatch.reserve(std::max(count, 2 * m_dispatch.capacity()));
+        }
+    }
+
+    detail::BlockArena m_arena;
+    std::vector<DispatchEntry> m_dispatch;
+};
+
+} // namespace chain
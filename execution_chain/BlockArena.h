@@ -0,0 +1,413 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+// Thrown when a block whose type is not copy constructible has to be copied,
+// e.g. when copying a chain holding a stateful move-only action
+class bad_block_copy : public std::exception
+{
+public:
+    bad_block_copy() noexcept = default;
+
+    const char* what() const noexcept override
+    {
+        return "Copy of a block which is not copy constructible";
+    }
+};
+
+namespace detail
+{
+
+// Type-erased lifetime operations of an object stored in a BlockArena.
+// One instance exists per stored type (see block_lifetime_v).
+struct BlockLifetime
+{
+    void (*copy)(const void* src, void* dst);
+    void (*relocate)(void* src, void* dst);
+    void (*destroy)(void* obj) noexcept;
+    std::size_t size;
+    std::size_t align;
+    const std::type_info* type;
+    // copy does not throw bad_block_copy
+    bool copyable;
+    // relocate moves the object and cannot throw
+    bool nothrow_relocatable;
+};
+
+template <class T>
+struct block_lifetime
+{
+    static void copy(const void* src, void* dst)
+    {
+        if constexpr (std::is_copy_constructible_v<T>)
+        {
+            ::new (dst) T(*static_cast<const T*>(src));
+        }
+        else
+        {
+            throw bad_block_copy{};
+        }
+    }
+
+    // Constructs the object at dst from the one at src, the source is destroyed
+    // by the caller once every object of the arena has been relocated.
+    static void relocate(void* src, void* dst)
+    {
+        ::new (dst) T(std::move_if_noexcept(*static_cast<T*>(src)));
+    }
+
+    static void destroy(void* obj) noexcept
+    {
+        static_cast<T*>(obj)->~T();
+    }
+};
+
+constexpr std::size_t align_up(std::size_t value, std::size_t align) noexcept
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+template <class T>
+inline constexpr BlockLifetime block_lifetime_v {
+    &block_lifetime<T>::copy,
+    &block_lifetime<T>::relocate,
+    &block_lifetime<T>::destroy,
+    sizeof(T),
+    alignof(T),
+    &typeid(T),
+    std::is_copy_constructible_v<T>,
+    std::is_nothrow_move_constructible_v<T>
+};
+
+/**
+ * \brief BlockArena stores objects of heterogeneous types in a single contiguous,
+ * suitably aligned byte buffer. <br>
+ * Objects are addressed by their offset in the buffer, offsets remain valid when the
+ * buffer grows, when the arena is copied and when it is moved. <br>
+ * Copying an arena copies each stored object through its copy constructor,
+ * moving an arena steals the buffer and leaves the source empty. <br>
+ * The buffer and the records are allocated from the memory resource of the arena.
+ * As for the std::pmr containers, a copy uses the default resource unless one is provided.
+ */
+class BlockArena
+{
+    struct Record
+    {
+        const BlockLifetime* lifetime;
+        std::size_t offset;
+    };
+
+    struct BufferDeleter
+    {
+        std::pmr::memory_resource* resource = nullptr;
+        std::size_t bytes = 0;
+        std::size_t align = alignof(std::max_align_t);
+
+        void operator()(std::byte* p) const noexcept
+        {
+            resource->deallocate(p, bytes, align);
+        }
+    };
+
+    using Buffer_t = std::unique_ptr<std::byte[], BufferDeleter>;
+
+    // capacity of the buffers after the first one, which is sized to its first object
+    static constexpr std::size_t min_capacity = 256;
+
+public:
+    BlockArena() noexcept
+        : BlockArena(std::pmr::get_default_resource())
+    {
+    }
+
+    explicit BlockArena(std::pmr::memory_resource* resource) noexcept
+        : m_records(resource)
+        , m_buffer(nullptr, BufferDeleter{ resource })
+    {
+    }
+
+    BlockArena(const BlockArena& other)
+        : BlockArena(other, std::pmr::get_default_resource())
+    {
+    }
+
+    BlockArena(const BlockArena& other, std::pmr::memory_resource* resource)
+        : m_records(other.m_records, resource)
+        , m_buffer(allocate(resource, other.m_size, other.m_align))
+        , m_size(other.m_size)
+        , m_capacity(other.m_size)
+        , m_align(other.m_align)
+    {
+        std::size_t copied = 0;
+        try
+        {
+            for (; copied < m_records.size(); ++copied)
+            {
+                const auto& record = m_records[copied];
+                record.lifetime->copy(other.data() + record.offset, data() + record.offset);
+            }
+        }
+        catch (...)
+        {
+            destroy_records(copied);
+            throw;
+        }
+    }
+
+    BlockArena(BlockArena&& other) noexcept
+        : m_records(std::move(other.m_records))
+        , m_buffer(std::move(other.m_buffer))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_capacity(std::exchange(other.m_capacity, 0))
+        , m_align(std::exchange(other.m_align, alignof(std::max_align_t)))
+    {
+        other.m_records.clear();
+    }
+
+    // An assigned arena keeps its memory resource, the objects are copied when the resources differ
+    BlockArena& operator=(const BlockArena& other)
+    {
+        if (this != &other)
+        {
+            BlockArena copy(other, resource());
+            swap(copy);
+        }
+        return *this;
+    }
+
+    BlockArena& operator=(BlockArena&& other)
+    {
+        if (this != &other)
+        {
+            if (*resource() != *other.resource())
+            {
+                return *this = static_cast<const BlockArena&>(other);
+            }
+            BlockArena moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    ~BlockArena()
+    {
+        clear();
+    }
+
+    // The arenas must use the same memory resource
+    void swap(BlockArena& other) noexcept
+    {
+        assert(*resource() == *other.resource() && "BlockArena : swapping arenas of different memory resources");
+        m_records.swap(other.m_records);
+        std::swap(m_buffer, other.m_buffer);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_align, other.m_align);
+    }
+
+    // Constructs a T in the arena and returns its offset
+    template <class T, class... Ts>
+    std::size_t emplace(Ts&&... args)
+    {
+        const std::size_t offset = reserve_slot(sizeof(T), alignof(T));
+        ::new (data() + offset) T(std::forward<Ts>(args)...);
+        commit_slot(&block_lifetime_v<T>, offset, sizeof(T));
+        return offset;
+    }
+
+    // Allocates the buffer and the records for `count` objects taking `bytes` bytes (padding included) :
+    // storing them then allocates nothing more. Never shrinks the arena.
+    void reserve(std::size_t bytes, std::size_t align, std::size_t count)
+    {
+        if (bytes > m_capacity || align > m_align)
+        {
+            reallocate(std::max(bytes, m_capacity), std::max(align, m_align));
+        }
+        m_records.reserve(count);
+    }
+
+    // Moves the index-th object of another arena at the end of this one and returns its offset.
+    // The moved-from object stays in the other arena, which destroys it.
+    std::size_t relocate_from(BlockArena& other, std::size_t index)
+    {
+        assert(&other != this && "BlockArena : relocating an object in its own arena");
+        const Record& record = other.m_records[index];
+        const auto* lifetime = record.lifetime;
+        const std::size_t offset = reserve_slot(lifetime->size, lifetime->align);
+        lifetime->relocate(other.data() + record.offset, data() + offset);
+        commit_slot(lifetime, offset, lifetime->size);
+        return offset;
+    }
+
+    // Copies the index-th object of another arena at the end of this one and returns its offset
+    std::size_t copy_from(const BlockArena& other, std::size_t index)
+    {
+        // copied by value : reserve_slot may reallocate the records when other is this arena
+        const Record record = other.m_records[index];
+        const auto* lifetime = record.lifetime;
+        const std::size_t offset = reserve_slot(lifetime->size, lifetime->align);
+        lifetime->copy(other.data() + record.offset, data() + offset);
+        commit_slot(lifetime, offset, lifetime->size);
+        return offset;
+    }
+
+    void clear() noexcept
+    {
+        destroy_records(m_records.size());
+        m_records.clear();
+        m_size = 0;
+    }
+
+    std::byte* data() const noexcept
+    {
+        return m_buffer.get();
+    }
+
+    // number of objects stored in the arena
+    std::size_t count() const noexcept
+    {
+        return m_records.size();
+    }
+
+    // number of bytes used by the stored objects (padding included)
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    // alignment of the buffer, the largest alignment of the stored objects
+    std::size_t alignment() const noexcept
+    {
+        return m_align;
+    }
+
+    // number of objects the records can hold before being reallocated
+    std::size_t record_capacity() const noexcept
+    {
+        return m_records.capacity();
+    }
+
+    // bytes of the record of an object
+    static constexpr std::size_t record_size() noexcept
+    {
+        return sizeof(Record);
+    }
+
+    const BlockLifetime& lifetime(std::size_t index) const noexcept
+    {
+        return *m_records[index].lifetime;
+    }
+
+    std::size_t offset(std::size_t index) const noexcept
+    {
+        return m_records[index].offset;
+    }
+
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return m_records.get_allocator().resource();
+    }
+
+private:
+    static Buffer_t allocate(std::pmr::memory_resource* resource, std::size_t bytes, std::size_t align)
+    {
+        if (bytes == 0)
+        {
+            return Buffer_t(nullptr, BufferDeleter{ resource, 0, align });
+        }
+        return Buffer_t(static_cast<std::byte*>(resource->allocate(bytes, align)), BufferDeleter{ resource, bytes, align });
+    }
+
+    // Returns the offset of a free slot of the given size and alignment, growing the buffer if needed
+    std::size_t reserve_slot(std::size_t size, std::size_t align)
+    {
+        const std::size_t offset = align_up(m_size, align);
+        if (offset + size > m_capacity || align > m_align)
+        {
+            grow(std::max(offset + size, m_capacity * 2), std::max(align, m_align));
+        }
+        if (m_records.size() == m_records.capacity())
+        {
+            // keeps commit_slot noexcept
+            m_records.reserve(std::max<std::size_t>(4, m_records.capacity() * 2));
+        }
+        return offset;
+    }
+
+    void commit_slot(const BlockLifetime* lifetime, std::size_t offset, std::size_t size) noexcept
+    {
+        m_records.push_back({ lifetime, offset });
+        m_size = offset + size;
+    }
+
+    void grow(std::size_t capacity, std::size_t align)
+    {
+        reallocate(m_capacity == 0 ? capacity : std::max(capacity, min_capacity), align);
+    }
+
+    // Relocates every stored object in a new buffer. Objects keep their offset.
+    void reallocate(std::size_t capacity, std::size_t align)
+    {
+        Buffer_t buffer = allocate(resource(), capacity, align);
+
+        std::size_t relocated = 0;
+        try
+        {
+            for (; relocated < m_records.size(); ++relocated)
+            {
+                const auto& record = m_records[relocated];
+                record.lifetime->relocate(data() + record.offset, buffer.get() + record.offset);
+            }
+        }
+        catch (...)
+        {
+            for (std::size_t i = 0; i < relocated; ++i)
+            {
+                m_records[i].lifetime->destroy(buffer.get() + m_records[i].offset);
+            }
+            throw;
+        }
+
+        destroy_records(m_records.size());
+        m_buffer = std::move(buffer);
+        m_capacity = capacity;
+        m_align = align;
+    }
+
+    void destroy_records(std::size_t count) noexcept
+    {
+        for (std::size_t i = count; i > 0; --i)
+        {
+            const auto& record = m_records[i - 1];
+            record.lifetime->destroy(data() + record.offset);
+        }
+    }
+
+    std::pmr::vector<Record> m_records;
+    Buffer_t m_buffer;
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+    std::size_t m_align = alignof(std::max_align_t);
+};
+
+} // namespace detail
+
+} // namespace chain
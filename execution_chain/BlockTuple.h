@@ -0,0 +1,604 @@
+#pragma once
+
+#include "ArgumentCopy.h"
+#include "Deadline.h"
+#include "ExecutionPolicy.h"
+#include "FieldAccess.h"
+#include "Instrumentation.h"
+#include "MemoryUsage.h"
+#include "Result.h"
+#include "ThreadPool.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace chain
+{
+
+template <class... Actions>
+class BlockTuple;
+
+template <class Policy, class... Args>
+class BasicExecutionChain;
+
+// Executes every block of the chain
+template <class... Args>
+using ExecutionChain = BasicExecutionChain<ExecutionPolicy::RunToEnd, Args...>;
+
+// Stops the execution at the first block returning false
+template <class... Args>
+using ShortCircuitChain = BasicExecutionChain<ExecutionPolicy::ShortCircuit, Args...>;
+
+template <class Policy, class... Args>
+class BasicAsyncExecutionChain;
+
+// The structs below are used as predicate trait to detect if a certain
+// structure is of a given type (ExecutionChain or BlockTuple).
+
+template<class T>
+struct is_block_tuple : std::false_type {};
+
+template<class... T>
+struct is_block_tuple<BlockTuple<T...>> : std::true_type {};
+
+template<class T>
+inline constexpr bool is_block_tuple_v = is_block_tuple<T>::value;
+
+template<class... T>
+struct is_execution_chain : std::false_type{};
+
+template<class Policy, class... T>
+struct is_execution_chain<BasicExecutionChain<Policy, T...>> : std::true_type {};
+
+// The aliases below are used as contrains to enable methods depending on the provided template argument type
+
+template<class... NotBlockTupleT>
+using enable_if_not_block_tuple = std::enable_if_t<!std::conjunction_v<is_block_tuple<std::decay_t<NotBlockTupleT>>...>, bool>;
+
+template<class MaybeExecutionChain>
+using enable_if_not_chain = std::enable_if_t<!is_execution_chain<std::decay_t<MaybeExecutionChain>>::value, bool>;
+
+template<class MaybeExecutionChain>
+using enable_if_chain = std::enable_if_t<is_execution_chain<std::decay_t<MaybeExecutionChain>>::value, bool>;
+
+template<class... MaybeExecutionChain>
+using enable_if_chains = std::enable_if_t<std::conjunction_v<is_execution_chain<std::decay_t<MaybeExecutionChain>>...>, bool>;
+
+// An action doing nothing : it is dropped when appended to a BlockTuple or an ExecutionChain.
+// It is for instance the result of an If whose predicate is false at compile time (see ExecutionFlow.h).
+struct NoOp
+{
+    template<class... Args>
+    constexpr void operator()(Args&&...) const noexcept {}
+};
+
+/**
+ * \brief is_shareable tells whether the copies of an ExecutionChain may share an action instead of copying it. <br>
+ * The empty actions and the function pointers are shareable. Any other action opts in by declaring the member type
+ * `using shareable = std::true_type;` (local classes included), or by a specialization of is_shareable, and must then
+ * be callable as const : an action with a mutable member, or modifying a state through a pointer or a reference, must not.
+ * \code{.cpp}
+ *    struct Scale {
+ *        using shareable = std::true_type;
+ *        void operator()(int& value) const { value *= factor; }
+ *        int factor;
+ *    };
+ * \endcode
+ * The BlockTuples and the steps of ExecutionFlow.h are shareable when all their actions are.
+*/
+template <class Action, class = void>
+struct is_shareable : std::bool_constant<std::is_empty_v<Action> ||
+                                         (std::is_pointer_v<Action> && std::is_function_v<std::remove_pointer_t<Action>>)> {};
+
+template <class Action>
+struct is_shareable<Action, std::void_t<typename Action::shareable>> : Action::shareable {};
+
+template <class Action>
+inline constexpr bool is_shareable_v = is_shareable<Action>::value;
+
+namespace detail {
+
+// The actions stored by a step are all shareable (see is_shareable)
+template<class... Actions>
+inline constexpr bool shareable_v = (is_shareable_v<std::remove_cvref_t<Actions>> && ...);
+
+// A step is foldable when it can be replaced, at compile time, by a simpler action : its Fold() && method
+// returns that action (e.g. the selected branch of an If with a constant predicate).
+template<class Action>
+concept foldable = requires(Action&& action) { std::move(action).Fold(); };
+
+// Replaces the action by its fold, recursively (the fold of a branch may be foldable as well)
+template<class Action>
+constexpr auto fold(Action action)
+{
+    if constexpr (foldable<Action>) {
+        return fold(std::move(action).Fold());
+    }
+    else {
+        return action;
+    }
+}
+
+template<class T, class... Args>
+static inline constexpr bool returns_bool = std::is_same_v<bool, std::invoke_result_t<T, Args&...>>;
+
+// Calls the callable and returns its result if it returns a bool, true otherwise.
+// A Result (or an expected value) converts to its success, the error of a failure is raised to the
+// ErrorChannel of the execution (see Result.h).
+template<class Callable, class... Args>
+constexpr bool Call(Callable&& callable, Args&&... args)
+{
+    if constexpr (returns_bool<std::decay_t<Callable>, Args...>)
+    {
+        return callable(args...);
+    }
+    else if constexpr (expected_like<std::invoke_result_t<std::decay_t<Callable>, Args&...>>)
+    {
+        auto&& result = callable(args...);
+        if (!result.has_value())
+        {
+            raise_error(result.error());
+            return false;
+        }
+        return true;
+    }
+    else
+    {
+        callable(args...);
+        return true;
+    }
+}
+
+// An action provides a batch overload when it is invocable with the spans of the contexts,
+// for instance : struct A { void operator()(Pod&); void operator()(std::span<Pod>); };
+template<class Action, class... Ts>
+inline constexpr bool is_batch_invocable_v = std::is_invocable_v<Action&, std::span<Ts>...>;
+
+constexpr bool have_same_size()
+{
+    return true;
+}
+
+template<class T, class... Ts>
+constexpr bool have_same_size(const std::span<T>& first, const std::span<Ts>&... others)
+{
+    return ((first.size() == others.size()) && ...);
+}
+
+// Runs the action over the whole batch : once with the spans if the action provides a batch overload,
+// once per element otherwise. The i-th element of each span forms the arguments of the i-th call.
+template<class Action, class... Ts>
+constexpr void execute_batch(Action& action, std::span<Ts>... batches)
+{
+    if constexpr (is_block_tuple_v<std::remove_const_t<Action>>) {
+        action.ExecuteBatch(batches...);
+    }
+    else if constexpr (is_batch_invocable_v<Action, Ts...>) {
+        std::invoke(action, batches...);
+    }
+    else {
+        std::size_t count = 0;
+        ((count = batches.size()), ...);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::invoke(action, batches[i]...);
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief BlockTuple builds a compile-time list of actions. <br>
+ * Therefore there is no indirection when passing from action to the next one. <br>
+ * The BlockTuple can be executed as such or moved to an ExecutionChain
+ * Compared to an ExecutionChain, the BlockTuple exposes the list of actions
+ * instead of the list of types expected for execution. <br>
+ * As a consequence, the BlockTuple can be executed with all the () overloads supported
+ * by the ActionsT. <br>
+ * For instance, the class below is invocable both with an int and a std::string :
+ * \code{.cpp}
+ * struct MyAction { void operator()(int); void operator()(std::string); };
+ * auto handler = start_chain | MyAction{} | MyAction{}; // repeats MyAction
+ * \endcode
+ * Therefore, BlockTuple<MyAction> handler can be used as :
+ * \code{.cpp}
+ * handler(int{5}); // with an int
+ * handler("Coucou"); // with a std::string
+ * // Because of MyAction, both of the above calls are valid.
+ * \endcode
+*/
+template <class... ActionsT>
+class BlockTuple
+{
+    using ActionTuple_t = std::tuple<ActionsT...>;
+public:
+    template<class... OtherActionsT, enable_if_not_block_tuple<OtherActionsT...> = true>
+    constexpr explicit BlockTuple(OtherActionsT&&... actions) : m_actions(std::forward<OtherActionsT>(actions)...) {}
+
+    // the empty BlockTuple, e.g. start_chain | NoOp{}
+    constexpr BlockTuple() requires (sizeof...(ActionsT) == 0) = default;
+
+    BlockTuple(const BlockTuple&) = default;
+    BlockTuple(BlockTuple&&) = default;
+
+    template<class... ArgsT>
+    struct are_actions_invocable;
+
+    // With EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS, the actions taking by value an argument expensive to copy are
+    // not invocable (see ArgumentCopy.h)
+    template<template<class...> class BlockTupleT, class... Actions, class... ArgsT>
+    struct are_actions_invocable<BlockTupleT<Actions...>, ArgsT...>
+        : std::conjunction<std::is_invocable<Actions, ArgsT&...>...,
+                           std::bool_constant<detail::is_copy_accepted_v<Actions, ArgsT...>>...> {};
+
+    template<template<class...> class BlockTupleT, class... Actions, class... ArgsT>
+    struct are_actions_invocable<const BlockTupleT<Actions...>, ArgsT...>
+        : std::conjunction<std::is_invocable<const Actions&, ArgsT&...>...,
+                           std::bool_constant<detail::is_copy_accepted_v<Actions, ArgsT...>>...> {};
+
+    // Executes the actions in order, returns true if the execution ran to the end.
+    // With the ShortCircuit policy (Execute<ExecutionPolicy::ShortCircuit>(args...)),
+    // the execution stops at the first action returning false.
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool Execute(ArgsT&&... args) const
+    {
+        return ExecuteActions<Policy>(*this, std::forward<ArgsT>(args)...);
+    }
+
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool Execute(ArgsT&&... args)
+    {
+        return ExecuteActions<Policy>(*this, std::forward<ArgsT>(args)...);
+    }
+
+    // Executes the actions within the time budget of the deadline, see ExecutionChain::Execute(deadline, args...)
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    bool Execute(Deadline& deadline, ArgsT&&... args) const
+    {
+        detail::DeadlineScope scope(deadline);
+        return ExecuteActions<Policy>(*this, scope, args...);
+    }
+
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    bool Execute(Deadline& deadline, ArgsT&&... args)
+    {
+        detail::DeadlineScope scope(deadline);
+        return ExecuteActions<Policy>(*this, scope, args...);
+    }
+
+    template <class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                  const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool operator()(ArgsT&&... args) const
+    {
+        return Execute(std::forward<ArgsT>(args)...);
+    }
+
+    template <class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                  BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool operator()(ArgsT&&... args)
+    {
+        return Execute(std::forward<ArgsT>(args)...);
+    }
+
+    // Number of actions, once the NoOp and foldable actions were simplified
+    static constexpr std::size_t size() noexcept
+    {
+        return sizeof...(ActionsT);
+    }
+
+    // The fields of the context read and written by the actions (see Access), when stored in an ExecutionChain
+    static constexpr FieldMask reads = (NoFields | ... | detail::fields_read<ActionsT>());
+    static constexpr FieldMask writes = (NoFields | ... | detail::fields_written<ActionsT>());
+
+    // Shared by the copies of an ExecutionChain when all the actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<ActionsT...>>;
+
+    // Executes the actions reading a dirty field, see ExecutionChain::ExecuteIncremental
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool ExecuteIncremental(FieldMask& dirty, ArgsT&&... args) const
+    {
+        detail::DirtyFields fields{ dirty };
+        const bool ranToEnd = ExecuteDirtyActions<Policy>(*this, fields, args...);
+        dirty = ranToEnd ? fields.pending : fields.pending | fields.dirty;
+        return ranToEnd;
+    }
+
+    template <class Policy = ExecutionPolicy::RunToEnd, class... ArgsT,
+              std::enable_if_t<are_actions_invocable<
+                    BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
+    constexpr bool ExecuteIncremental(FieldMask& dirty, ArgsT&&... args)
+    {
+        detail::DirtyFields fields{ dirty };
+        const bool ranToEnd = ExecuteDirtyActions<Policy>(*this, fields, args...);
+        dirty = ranToEnd ? fields.pending : fields.pending | fields.dirty;
+        return ranToEnd;
+    }
+
+    // Returns the bytes of each action, the padding of the tuple being its overhead (see MemoryUsage).
+    // The actions are stored in the BlockTuple : it holds no slack.
+    MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage;
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (usage.blocks.push_back(BlockMemory{ I, action_type<ActionsT>(), action_size<ActionsT>(), 0, false }), ...);
+        }(std::index_sequence_for<ActionsT...>{});
+        usage.actions = (action_size<ActionsT>() + ... + 0);
+        // the tail padding of an action may hold the next one
+        usage.overhead = sizeof(BlockTuple) > usage.actions ? sizeof(BlockTuple) - usage.actions : 0;
+        return usage;
+    }
+
+    // Executes the actions one by one over the batch of contexts : each action runs on every context
+    // before the next action starts. With several arguments, the spans are zipped and must have the same size.
+    template <class... Ts>
+    constexpr void ExecuteBatch(std::span<Ts>... batches) const
+    {
+        assert(detail::have_same_size(batches...) && "ExecuteBatch : the batches must have the same size");
+        std::apply([&](auto&... actions)
+        {
+            (detail::execute_batch(actions, batches...), ...);
+        }, m_actions);
+    }
+
+    template <class... Ts>
+    constexpr void ExecuteBatch(std::span<Ts>... batches)
+    {
+        assert(detail::have_same_size(batches...) && "ExecuteBatch : the batches must have the same size");
+        std::apply([&](auto&... actions)
+        {
+            (detail::execute_batch(actions, batches...), ...);
+        }, m_actions);
+    }
+
+    // Splits the batch in chunks of grain contexts and runs ExecuteBatch on each chunk on the pool.
+    // The actions are shared by the threads and must be safe to call concurrently.
+    template <class... Ts>
+    void ExecuteParallel(ThreadPool& pool, std::size_t grain, std::span<Ts>... batches) const
+    {
+        assert(detail::have_same_size(batches...) && "ExecuteParallel : the batches must have the same size");
+        std::size_t count = 0;
+        ((count = batches.size()), ...);
+        pool.ParallelFor(count, grain, [&](std::size_t begin, std::size_t end)
+        {
+            ExecuteBatch(batches.subspan(begin, end - begin)...);
+        });
+    }
+
+    // Same as above, with the default grain of the pool
+    template <class... Ts>
+    void ExecuteParallel(ThreadPool& pool, std::span<Ts>... batches) const
+    {
+        std::size_t count = 0;
+        ((count = batches.size()), ...);
+        ExecuteParallel(pool, pool.DefaultGrain(count), batches...);
+    }
+
+    // The actions of an rvalue BlockTuple are moved in the result, they are copied otherwise
+    template <class... OtherActions>
+    constexpr BlockTuple<ActionsT..., OtherActions...> operator|(BlockTuple<OtherActions...> other) const&
+    {
+        return BlockTuple<ActionsT..., OtherActions...>(std::tuple_cat(m_actions, std::move(other.m_actions)));
+    }
+
+    template <class... OtherActions>
+    constexpr BlockTuple<ActionsT..., OtherActions...> operator|(BlockTuple<OtherActions...> other) &&
+    {
+        return BlockTuple<ActionsT..., OtherActions...>(std::tuple_cat(std::move(m_actions), std::move(other.m_actions)));
+    }
+
+    // The foldable actions are appended as their fold (whose actions are appended one by one if it is a
+    // BlockTuple), the NoOp actions are dropped
+    template <class OtherActionT, enable_if_not_block_tuple<OtherActionT> = true>
+    constexpr auto operator|(OtherActionT&& other) const&
+    {
+        if constexpr (detail::foldable<std::decay_t<OtherActionT>>) {
+            return *this | detail::fold(std::decay_t<OtherActionT>(std::forward<OtherActionT>(other)));
+        }
+        else if constexpr (std::is_same_v<std::decay_t<OtherActionT>, NoOp>) {
+            return *this;
+        }
+        else {
+            return BlockTuple<ActionsT..., std::decay_t<OtherActionT>>(std::tuple_cat(
+                m_actions, std::tuple<std::decay_t<OtherActionT>>(std::forward<OtherActionT>(other))));
+        }
+    }
+
+    template <class OtherActionT, enable_if_not_block_tuple<OtherActionT> = true>
+    constexpr auto operator|(OtherActionT&& other) &&
+    {
+        if constexpr (detail::foldable<std::decay_t<OtherActionT>>) {
+            return std::move(*this) | detail::fold(std::decay_t<OtherActionT>(std::forward<OtherActionT>(other)));
+        }
+        else if constexpr (std::is_same_v<std::decay_t<OtherActionT>, NoOp>) {
+            return std::move(*this);
+        }
+        else {
+            return BlockTuple<ActionsT..., std::decay_t<OtherActionT>>(std::tuple_cat(
+                std::move(m_actions), std::tuple<std::decay_t<OtherActionT>>(std::forward<OtherActionT>(other))));
+        }
+    }
+
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // Returns the execution statistics of each action, indexed by the position of the action in the BlockTuple.
+    // Only Execute is measured.
+    ChainReport Report() const
+    {
+        ChainReport report;
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (report.blocks.push_back(detail::make_block_report(I, std::get<I>(m_actions), m_profiles[I])), ...);
+        }(std::index_sequence_for<ActionsT...>{});
+        return report;
+    }
+
+    // Resets the statistics of the actions
+    void ResetReport() const noexcept
+    {
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (detail::reset_block_report(std::get<I>(m_actions), m_profiles[I]), ...);
+        }(std::index_sequence_for<ActionsT...>{});
+    }
+#endif
+
+private:
+    template <class Policy, class Self, class... ArgsT>
+    static constexpr bool ExecuteActions(Self& self, ArgsT&&... args)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            if constexpr (Policy::short_circuit)
+            {
+                return (self.template Measure<I>([&] { return detail::Call(std::get<I>(self.m_actions), args...); }) && ...);
+            }
+            else
+            {
+                (self.template Measure<I>([&] { detail::Call(std::get<I>(self.m_actions), args...); }), ...);
+                return true;
+            }
+        }(std::index_sequence_for<ActionsT...>{});
+    }
+
+    // Same as above, the position of each action is given to the deadline of the execution before it runs
+    template <class Policy, class Self, class... ArgsT>
+    static bool ExecuteActions(Self& self, detail::DeadlineScope& scope, ArgsT&... args)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            if constexpr (Policy::short_circuit)
+            {
+                return ((scope.Enter(I), self.template Measure<I>([&] { return detail::Call(std::get<I>(self.m_actions), args...); })) && ...);
+            }
+            else
+            {
+                ((scope.Enter(I), self.template Measure<I>([&] { detail::Call(std::get<I>(self.m_actions), args...); })), ...);
+                return true;
+            }
+        }(std::index_sequence_for<ActionsT...>{});
+    }
+
+    // The masks of the actions are known at compile time : only the test of the dirty fields remains
+    template <class Policy, class Self, class... ArgsT>
+    static constexpr bool ExecuteDirtyActions(Self& self, detail::DirtyFields& fields, ArgsT&... args)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            const auto run = [&]<std::size_t J, class Action>(std::integral_constant<std::size_t, J>, Action*)
+            {
+                return fields.template run_action<Action>([&]
+                {
+                    return self.template Measure<J>([&] { return detail::Call(std::get<J>(self.m_actions), args...); });
+                });
+            };
+            if constexpr (Policy::short_circuit)
+            {
+                return (run(std::integral_constant<std::size_t, I>{}, static_cast<ActionsT*>(nullptr)) && ...);
+            }
+            else
+            {
+                (run(std::integral_constant<std::size_t, I>{}, static_cast<ActionsT*>(nullptr)), ...);
+                return true;
+            }
+        }(std::index_sequence_for<ActionsT...>{});
+    }
+
+    // Null when built without RTTI
+    template <class Action>
+    static const std::type_info* action_type() noexcept
+    {
+#if __cpp_rtti
+        return &typeid(Action);
+#else
+        return nullptr;
+#endif
+    }
+
+    // The empty actions take no room in the tuple
+    template <class Action>
+    static constexpr std::size_t action_size() noexcept
+    {
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        return (std::is_empty_v<Action> ? 0 : sizeof(Action)) + sizeof(detail::BlockProfile);
+#else
+        return std::is_empty_v<Action> ? 0 : sizeof(Action);
+#endif
+    }
+
+    // Calls fn, and records its latency as the one of the I-th action when the instrumentation is enabled
+    template <std::size_t I, class F>
+    constexpr decltype(auto) Measure(F&& fn) const
+    {
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        return m_profiles[I].measure(std::forward<F>(fn));
+#else
+        return std::forward<F>(fn)();
+#endif
+    }
+
+    template <class... OtherActionsT>
+    friend class BlockTuple;
+
+    // appends the actions one by one
+    template <class Policy, class... Args>
+    friend class BasicAsyncExecutionChain;
+
+    // executes the actions of a BlockTuple block incrementally
+    template <class Policy, class... Args>
+    friend class BasicExecutionChain;
+
+    ActionTuple_t m_actions;
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // the actions are executed from a const BlockTuple, their statistics are updated all the same
+    mutable std::array<detail::BlockProfile, sizeof...(ActionsT)> m_profiles;
+#endif
+};
+
+template <>
+class BlockTuple<void>
+{
+public:
+    template <class... OtherActions>
+    constexpr BlockTuple<OtherActions...> operator|(BlockTuple<OtherActions...> other) const
+    {
+        return other;
+    }
+
+    template <class OtherActionT, enable_if_not_block_tuple<OtherActionT> = true>
+    constexpr auto operator|(OtherActionT&& other) const
+    {
+        return BlockTuple<>{} | std::forward<OtherActionT>(other);
+    }
+};
+
+template<class... Actions>
+BlockTuple(Actions...) -> BlockTuple<Actions...>;
+
+// Call this function to kick off the definition of an execution chain
+// Usage : auto blockTuple = start_chain | Action1{} | Action2{};
+static inline constexpr auto start_chain =  BlockTuple<void>{};
+
+namespace ChainStep
+{
+    struct LogicFlow {};
+};
+
+} // namespace chain
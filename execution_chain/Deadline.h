@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+namespace detail
+{
+class DeadlineScope;
+}
+
+/**
+ * \brief A Deadline is the time budget of an execution : `chain.Execute(deadline, args...)` runs every block of
+ * the chain, but the Optional and Anytime steps are skipped once the deadline expired (see ExecutionFlow.h).
+ * \code{.cpp}
+ *    Deadline deadline;
+ *    while (true) {
+ *        deadline.Reset(std::chrono::milliseconds(45));
+ *        raceGamePlay.Execute(deadline, race);
+ *        for (std::size_t block : deadline.Skipped()) { ... }
+ *    }
+ * \endcode
+ * \details Expired reads the clock (std::chrono::steady_clock) once every checkInterval calls only, and
+ * remembers the expiration : an Anytime step polling the deadline in a tight loop stays cheap. <br>
+ * Skipped and Interrupted return the positions of the blocks in the executed chain (or of the actions in
+ * the executed BlockTuple). Reset keeps the capacity of these lists : a Deadline reused at every tick does not
+ * allocate once the lists got large enough.
+*/
+class Deadline
+{
+public:
+    using Clock_t = std::chrono::steady_clock;
+
+    // Never expires
+    Deadline() noexcept = default;
+
+    explicit Deadline(Clock_t::time_point at, std::size_t checkInterval = 1) noexcept
+        : m_at(at), m_checkInterval(checkInterval == 0 ? 1 : checkInterval)
+    {}
+
+    explicit Deadline(Clock_t::duration budget, std::size_t checkInterval = 1) noexcept
+        : Deadline(Clock_t::now() + budget, checkInterval)
+    {}
+
+    // Restarts the deadline and clears its report
+    void Reset(Clock_t::time_point at) noexcept
+    {
+        m_at = at;
+        m_countdown = 0;
+        m_expired = false;
+        m_skipped.clear();
+        m_interrupted.clear();
+    }
+
+    void Reset(Clock_t::duration budget) noexcept
+    {
+        Reset(Clock_t::now() + budget);
+    }
+
+    // Expired is called from the steps of a const chain : the countdown and the cached expiration are updated
+    // all the same. A Deadline must not be used by two executions at the same time.
+    bool Expired() const noexcept
+    {
+        if (m_expired || m_at == Clock_t::time_point::max()) {
+            return m_expired;
+        }
+        if (m_countdown > 0) {
+            --m_countdown;
+            return false;
+        }
+        m_countdown = m_checkInterval - 1;
+        m_expired = Clock_t::now() >= m_at;
+        return m_expired;
+    }
+
+    Clock_t::time_point At() const noexcept
+    {
+        return m_at;
+    }
+
+    // The Optional and Anytime blocks which were skipped because the deadline had expired
+    const std::vector<std::size_t>& Skipped() const noexcept
+    {
+        return m_skipped;
+    }
+
+    // The Anytime blocks which returned after the deadline expired, e.g. cut short by the expiration
+    const std::vector<std::size_t>& Interrupted() const noexcept
+    {
+        return m_interrupted;
+    }
+
+    void RecordSkipped()
+    {
+        m_skipped.push_back(m_block);
+    }
+
+    void RecordInterrupted()
+    {
+        m_interrupted.push_back(m_block);
+    }
+
+private:
+    Clock_t::time_point m_at = Clock_t::time_point::max();
+    std::size_t m_checkInterval = 1;
+    mutable std::size_t m_countdown = 0;
+    mutable bool m_expired = false;
+
+    // position of the block being executed
+    std::size_t m_block = 0;
+    std::vector<std::size_t> m_skipped;
+    std::vector<std::size_t> m_interrupted;
+
+    friend class detail::DeadlineScope;
+};
+
+namespace detail
+{
+
+// The deadline of the execution running on this thread, if any
+inline Deadline*& current_deadline() noexcept
+{
+    thread_local Deadline* t_deadline = nullptr;
+    return t_deadline;
+}
+
+// Makes the deadline the one of the current thread for the duration of an execution
+class DeadlineScope
+{
+public:
+    explicit DeadlineScope(Deadline& deadline) noexcept
+        : m_deadline(deadline), m_previous(std::exchange(current_deadline(), &deadline)), m_block(deadline.m_block)
+    {}
+
+    ~DeadlineScope()
+    {
+        m_deadline.m_block = m_block;
+        current_deadline() = m_previous;
+    }
+
+    DeadlineScope(const DeadlineScope&) = delete;
+    DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+    // The block at this position is being executed
+    void Enter(std::size_t block) noexcept
+    {
+        m_deadline.m_block = block;
+    }
+
+private:
+    Deadline& m_deadline;
+    Deadline* m_previous;
+    std::size_t m_block;
+};
+
+} // namespace detail
+
+} // namespace chain
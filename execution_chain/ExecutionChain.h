@@ -1,52 +1,20 @@
 #pragma once
 
+#include "BlockArena.h"
+#include "BlockTuple.h"
+#include "FrozenChain.h"
 #include "polymorphic_value.h"
+#include <algorithm>
+#include <cstddef>
 #include <memory>
-#include <tuple>
+#include <memory_resource>
+#include <span>
 #include <type_traits>
 #include <vector>
 
 namespace chain
 {
 
-template <class... Actions>
-class BlockTuple;
-
-template <class... Args>
-class ExecutionChain;
-
-// The structs below are used as predicate trait to detect if a certain
-// structure is of a given type (ExecutionChain or BlockTuple).
-
-template<class T>
-struct is_block_tuple : std::false_type {};
-
-template<class... T>
-struct is_block_tuple<BlockTuple<T...>> : std::true_type {};
-
-template<class T>
-inline constexpr bool is_block_tuple_v = is_block_tuple<T>::value;
-
-template<class... T>
-struct is_execution_chain : std::false_type{};
-
-template<class... T>
-struct is_execution_chain<ExecutionChain<T...>> : std::true_type {};
-
-// The aliases below are used as contrains to enable methods depending on the provided template argument type
-
-template<class... NotBlockTupleT>
-using enable_if_not_block_tuple = std::enable_if_t<!std::conjunction_v<is_block_tuple<std::decay_t<NotBlockTupleT>>...>, bool>;
-
-template<class MaybeExecutionChain>
-using enable_if_not_chain = std::enable_if_t<!is_execution_chain<std::decay_t<MaybeExecutionChain>>::value, bool>;
-
-template<class MaybeExecutionChain>
-using enable_if_chain = std::enable_if_t<is_execution_chain<std::decay_t<MaybeExecutionChain>>::value, bool>;
-
-template<class... MaybeExecutionChain>
-using enable_if_chains = std::enable_if_t<std::conjunction_v<is_execution_chain<std::decay_t<MaybeExecutionChain>>...>, bool>;
-
 /**
  * \brief A ExecutionChain allows the chaining of different actions together, 
  * and the ability to execute these actions in the order they were chained.
@@ -64,53 +32,154 @@ using enable_if_chains = std::enable_if_t<std::conjunction_v<is_execution_chain<
  * executors in the chain). <br>
  * The `start_chain` keyword is used to start the creation of a BlockTuple which may further be assigned to an ExecutionChain.
  * The operator| and operator|= operators are used for chaining of the actions, and the Execute and the operator() methods are
- * used to execute all the actions in the order they were added.
+ * used to execute all the actions in the order they were added. <br>
+ * ExecuteBatch runs the chain block by block over spans of contexts :
+ * \code{.cpp}
+ *    std::vector<Pod> pods = ...;
+ *    ExecutionChain<Pod&> chain = start_chain | Steer{} | Thrust{};
+ *    chain.ExecuteBatch(pods); // Steer on every pod, then Thrust on every pod
+ * \endcode
+ * Copying or composing chains does not copy the blocks whose action is shareable (see is_shareable) and callable
+ * as const : they are immutable and shared by reference count. The blocks of the other actions are copied, so that
+ * copies never share a state, along with the immutable blocks appended next to them.
 */ 
-template <class... Args>
-class ExecutionChain {
-    // IExecutionBlock represents a single block in the execution chain
-    class IExecutionBlock {
-    public:
-        virtual ~IExecutionBlock() = default;
-        virtual void Execute(Args&...) = 0;
-    };
-
-    // Concrete implementation of IExecutionBlock, storing a specific action
+template <class Policy, class... Args>
+class BasicExecutionChain {
+    // ExecutionBlock stores a specific action in the arena of the chain
     // An action could for instance : struct A { void operator()(int a, double b){} };
     // or a lambda
     template <class Action>
-    class ExecutionBlock : public IExecutionBlock {
+    class ExecutionBlock {
     public:
         struct is_action_invocable : std::is_invocable<Action, Args&...> {};
         static_assert(is_action_invocable::value, "The action must be invocable with the provided arguments.");
+        static_assert(detail::is_copy_accepted_v<Action, Args...>,
+            "The action takes by value an argument which is expensive to copy : take it by reference, or Project "
+            "the part of the context it needs (see EXECUTION_CHAIN_REJECT_COPIED_ARGUMENTS).");
 
-        explicit ExecutionBlock(Action&& action) : m_action(std::forward<Action>(action)) {}
-        explicit ExecutionBlock(Action& action) : m_action(std::move(action)) {}
-        explicit ExecutionBlock(const Action& action) : m_action(action) {}
+        template <class ActionT, std::enable_if_t<!std::is_same_v<std::decay_t<ActionT>, ExecutionBlock>, bool> = true>
+        explicit ExecutionBlock(ActionT&& action) : m_action(std::forward<ActionT>(action)) {}
 
-        // Calls the stored action with the given arguments
+        // A shareable action (see is_shareable) callable as const is never modified by its execution : the block
+        // is immutable and can be shared by several chains. It is then always called as const.
+        static constexpr bool is_immutable = is_shareable_v<Action> && std::is_invocable_v<const Action&, Args&...>;
+
+        // Calls the action stored in the block located at pBlock with the given arguments
         // If the stored action is a class, it must implement the operator()(Args... args)
         // For instance : struct A { void operator()(int a, double b){} };
-        void Execute(Args&... args) override {
-            assert((std::is_invocable_v<decltype(m_action), Args&...> &&
-                   "Action::operator() is not callable as non const"));
-            std::invoke(m_action, args...);
+        // Returns the result of the action if it returns a bool, true otherwise.
+        static bool Execute(void* pBlock, Args&... args) {
+#if EXECUTION_CHAIN_INSTRUMENTATION
+            return static_cast<ExecutionBlock*>(pBlock)->m_profile.measure([&] { return ExecuteAction(pBlock, args...); });
+#else
+            return ExecuteAction(pBlock, args...);
+#endif
+        }
+
+        // Executes the action if it reads a dirty field (see ExecuteIncremental).
+        // The actions of a BlockTuple are checked one by one.
+        static bool ExecuteIncremental(void* pBlock, detail::DirtyFields& fields, Args&... args) {
+            if constexpr (is_block_tuple_v<Action>) {
+                return Action::template ExecuteDirtyActions<Policy>(stored_action(pBlock), fields, args...);
+            }
+            else {
+                return fields.template run_action<Action>([&] { return Execute(pBlock, args...); });
+            }
+        }
+
+        // Calls the stored action over the whole batch (see detail::execute_batch)
+        static void ExecuteBatch(void* pBlock, std::span<std::remove_reference_t<Args>>... batches) {
+            detail::execute_batch(stored_action(pBlock), batches...);
+        }
+
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        static BlockReport Report(const void* pBlock, std::size_t index) {
+            const auto* block = static_cast<const ExecutionBlock*>(pBlock);
+            return detail::make_block_report(index, block->m_action, block->m_profile);
+        }
+
+        static void ResetReport(void* pBlock) noexcept {
+            auto* block = static_cast<ExecutionBlock*>(pBlock);
+            detail::reset_block_report(block->m_action, block->m_profile);
+        }
+#endif
+        // The action of an immutable block is const
+        using StoredAction_t = std::conditional_t<is_immutable, const Action, Action>;
+
+        static StoredAction_t& stored_action(void* pBlock) {
+            return static_cast<ExecutionBlock*>(pBlock)->m_action;
         }
+
     private:
+        static bool ExecuteAction(void* pBlock, Args&... args) {
+            auto& action = stored_action(pBlock);
+            assert((std::is_invocable_v<decltype(action), Args&...> &&
+                   "Action::operator() is not callable as non const"));
+            if constexpr (is_block_tuple_v<Action>) {
+                return action.template Execute<Policy>(args...);
+            }
+            else {
+                return detail::Call(action, args...);
+            }
+        }
+
         Action m_action;
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        detail::BlockProfile m_profile;
+#endif
     };
 
-    using ExecutionBlock_t = IExecutionBlock;
-    using ExecutionBlockList_t = std::vector<polymorphic_value<ExecutionBlock_t>>;
+    // Entry of the dispatch table : the block located at `offset` in the arena is executed by `execute`,
+    // by `execute_batch` for a batch of contexts, or by `execute_incremental` for an incremental execution
+    struct DispatchEntry {
+        bool (*execute)(void*, Args&...);
+        std::size_t offset;
+        void (*execute_batch)(void*, std::span<std::remove_reference_t<Args>>...);
+        bool (*execute_incremental)(void*, detail::DirtyFields&, Args&...);
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        BlockReport (*report)(const void*, std::size_t);
+        void (*reset_report)(void*) noexcept;
+#endif
+    };
+
+    using DispatchTable_t = std::pmr::vector<DispatchEntry>;
+
+    // A segment is a run of consecutive blocks of the chain, stored in their own arena.
+    // Segments are shared by reference count : copying or composing chains shares the segments
+    // instead of copying their blocks. A shared segment is immutable, blocks are only appended
+    // to the last segment of a chain when the chain is its only owner.
+    // A segment is stateful once it holds a stateful block : the actions of a stateful block are modified by
+    // their execution, the whole segment is copied, instead of shared, when the chain is copied.
+    // Immutable and stateful blocks share a segment as long as it stays copyable, so that alternating
+    // kinds do not split the chain in a segment per block.
+    // Segments are only shared by chains using the same memory resource.
+    struct Segment {
+        Segment(bool isStateful, std::pmr::memory_resource* resource)
+            : arena(resource), dispatch(resource), stateful(isStateful) {}
+
+        Segment(const Segment& other, std::pmr::memory_resource* resource)
+            : arena(other.arena, resource), dispatch(other.dispatch, resource), stateful(other.stateful),
+              copyable(other.copyable) {}
+
+        detail::BlockArena arena;
+        DispatchTable_t dispatch;
+        bool stateful = false;
+        // every block of the segment is copyable
+        bool copyable = true;
+    };
+
+    using SegmentPtr_t = std::shared_ptr<Segment>;
 
 public:
 
     template<class... ActionsT>
     struct are_actions_invocable : std::conjunction<std::is_invocable<ActionsT, Args&...>...> {};
 
+    // The actions of a BlockTuple copying an expensive argument are rejected as well (see ArgumentCopy.h)
     template<class... ActionsT>
     struct are_actions_invocable<BlockTuple<ActionsT...>>
-        : std::conjunction<std::is_invocable<ActionsT, Args&...>...> {};
+        : std::conjunction<std::is_invocable<ActionsT, Args&...>...,
+                           std::bool_constant<detail::is_copy_accepted_v<ActionsT, Args...>>...> {};
 
     template<class... ActionsT>
     using enable_if_actions_are_invocable = std::enable_if_t<are_actions_invocable<ActionsT...>::value, bool>;
@@ -120,28 +189,63 @@ public:
         is_block_tuple_v<std::decay_t<BlockTupleT>>
         && are_actions_invocable<std::decay_t<BlockTupleT>>::value, bool>;
 
-    ExecutionChain() {}
+    template<class MaybeResourceT>
+    using enable_if_not_memory_resource = std::enable_if_t<
+        !std::is_convertible_v<MaybeResourceT, std::pmr::memory_resource*>, bool>;
+
+    BasicExecutionChain() {}
+
+    // The blocks of the chain and their bookkeeping are allocated from resource, which must outlive the chain.
+    // As for the std::pmr containers, the resource is not propagated : copies use the default resource
+    // unless one is provided, and assignments keep the resource of the assigned chain.
+    explicit BasicExecutionChain(std::pmr::memory_resource* resource) : m_segments(resource) {}
+
+    BasicExecutionChain(const BasicExecutionChain& other)
+    {
+        append_blocks(other);
+    }
+
+    BasicExecutionChain(const BasicExecutionChain& other, std::pmr::memory_resource* resource)
+        : m_segments(resource)
+    {
+        append_blocks(other);
+    }
 
-    ExecutionChain(const ExecutionChain&) = default;
-    ExecutionChain(ExecutionChain&&) = default;
+    BasicExecutionChain(BasicExecutionChain&&) = default;
 
-    ExecutionChain& operator=(const ExecutionChain&) = default;
-    ExecutionChain& operator=(ExecutionChain&&) = default;
+    BasicExecutionChain& operator=(const BasicExecutionChain& other)
+    {
+        if (this != &other) {
+            BasicExecutionChain copy(other, resource());
+            m_segments.swap(copy.m_segments);
+        }
+        return *this;
+    }
+
+    BasicExecutionChain& operator=(BasicExecutionChain&& other)
+    {
+        if (this != &other) {
+            clear();
+            append_blocks(std::move(other));
+        }
+        return *this;
+    }
 
     template <class ActionT,
               enable_if_not_block_tuple<ActionT> = true,
-              enable_if_not_chain<ActionT> = true
+              enable_if_not_chain<ActionT> = true,
+              enable_if_not_memory_resource<ActionT> = true
     >
-    ExecutionChain(ActionT&& action)
+    BasicExecutionChain(ActionT&& action)
     {
-        append(action);
+        append(std::forward<ActionT>(action));
     }
 
     template <class BlockTupleT, enable_if_compatible_block_tuple<BlockTupleT> = true>
-    ExecutionChain(BlockTupleT&& handler)
+    BasicExecutionChain(BlockTupleT&& handler)
     {
         CheckBlockTupleCompatibility(handler);
-        append(handler);
+        append(std::forward<BlockTupleT>(handler));
     }
 
     // Clears the chain and append an action
@@ -149,75 +253,344 @@ public:
               enable_if_not_block_tuple<ActionT> = true,
               enable_if_not_chain<ActionT> = true
     >
-    ExecutionChain& operator=(ActionT&& action) {
-        m_blocks.clear();
-        return append(action);
+    BasicExecutionChain& operator=(ActionT&& action) {
+        clear();
+        return append(std::forward<ActionT>(action));
     }
 
     // Append an action to the chain
     template <class ActionT, enable_if_not_block_tuple<ActionT> = true>
-    ExecutionChain& operator|=(ActionT&& action) {
-        return append(action);
+    BasicExecutionChain& operator|=(ActionT&& action) {
+        return append(std::forward<ActionT>(action));
     }
 
+    // false, instead of an error, for a wrong number of arguments (e.g. for Execute(deadline, args...))
     template<class... ExecArgsT>
-    struct acceptable_args : std::conjunction<std::is_convertible<ExecArgsT, Args>...> {};
+    static constexpr bool are_args_acceptable() {
+        if constexpr (sizeof...(ExecArgsT) == sizeof...(Args)) {
+            return std::conjunction_v<std::is_convertible<ExecArgsT, Args>...>;
+        }
+        else {
+            return false;
+        }
+    }
+
+    template<class... ExecArgsT>
+    struct acceptable_args : std::bool_constant<are_args_acceptable<ExecArgsT...>()> {};
 
     template<class... ExecArgsT>
     using enable_if_all_args_are_compatible = std::enable_if_t<acceptable_args<ExecArgsT...>::value, bool>;
 
+    // Executes the blocks in order, returns true if the chain ran to the end.
+    // With the ShortCircuit policy, the execution stops at the first block returning false.
     template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
-    void Execute(ExecArgsT&&... args) const {
-        for (const auto& block : m_blocks) {
-            block.get()->Execute(args...);
+    bool Execute(ExecArgsT&&... args) const {
+        for (const auto& segment : m_segments) {
+            std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                if constexpr (Policy::short_circuit) {
+                    if (!entry.execute(arena + entry.offset, args...)) {
+                        return false;
+                    }
+                }
+                else {
+                    entry.execute(arena + entry.offset, args...);
+                }
+            }
+        }
+        return true;
+    }
+
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool operator()(ExecArgsT&&... args) const {
+        return Execute(args...);
+    }
+
+    // Executes the blocks in order within the time budget of the deadline : every block is executed, except
+    // the Optional and Anytime steps reached once the deadline expired (see Deadline)
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool Execute(Deadline& deadline, ExecArgsT&&... args) const {
+        detail::DeadlineScope scope(deadline);
+        std::size_t block = 0;
+        for (const auto& segment : m_segments) {
+            std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                scope.Enter(block++);
+                if (!entry.execute(arena + entry.offset, args...) && Policy::short_circuit) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Executes the blocks in order, the errors of the blocks failing with a Result<E> (or an expected value) are
+    // recorded by the channel with the position of the block (see ErrorChannel). The actions of a BlockTuple
+    // appended at once form a single block.
+    template<class E, class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool Execute(ErrorChannel<E>& errors, ExecArgsT&&... args) const {
+        detail::ErrorScope<E> scope(errors);
+        std::size_t block = 0;
+        for (const auto& segment : m_segments) {
+            std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                const bool succeeded = entry.execute(arena + entry.offset, args...);
+                scope.Leave(block++);
+                if (!succeeded && Policy::short_circuit) {
+                    return false;
+                }
+            }
         }
+        return true;
     }
 
+    // Executes the blocks reading a field of the context marked as dirty, the other blocks are skipped : their
+    // results from the previous executions are still valid. The fields written by an executed block are marked
+    // as dirty for the next blocks (see Access to declare the fields of the actions).
+    // dirty holds the fields modified since the previous execution, AllFields for the first one. It is replaced
+    // by the fields to execute again at the next execution : the ones written for a block which was already
+    // checked (e.g. a block reading and writing the same field), or all the dirty fields when a ShortCircuit
+    // chain stopped before its end.
     template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
-    void operator()(ExecArgsT&&... args) const {
-        Execute(args...);
+    bool ExecuteIncremental(FieldMask& dirty, ExecArgsT&&... args) const {
+        detail::DirtyFields fields{ dirty };
+        const bool ranToEnd = [&] {
+            for (const auto& segment : m_segments) {
+                std::byte* const arena = segment->arena.data();
+                for (const auto& entry : segment->dispatch) {
+                    if (!entry.execute_incremental(arena + entry.offset, fields, args...) && Policy::short_circuit) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }();
+        dirty = ranToEnd ? fields.pending : fields.pending | fields.dirty;
+        return ranToEnd;
     }
 
+    // Executes the chain block by block over the batch of contexts : each block runs on every context before
+    // the next block starts. With several arguments, the spans are zipped and must have the same size.
+    void ExecuteBatch(std::span<std::remove_reference_t<Args>>... batches) const {
+        static_assert(!Policy::short_circuit, "ExecuteBatch runs every block on every context, "
+            "it is not available with the ShortCircuit policy");
+        assert(detail::have_same_size(batches...) && "ExecuteBatch : the batches must have the same size");
+        for (const auto& segment : m_segments) {
+            std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                entry.execute_batch(arena + entry.offset, batches...);
+            }
+        }
+    }
+
+    // Splits the batch in chunks of grain contexts and runs ExecuteBatch on each chunk on the pool.
+    // The blocks are shared by the threads : their actions must be safe to call concurrently
+    // (e.g. stateless, or const with no mutable state).
+    void ExecuteParallel(ThreadPool& pool, std::size_t grain,
+                         std::span<std::remove_reference_t<Args>>... batches) const {
+        assert(detail::have_same_size(batches...) && "ExecuteParallel : the batches must have the same size");
+        std::size_t count = 0;
+        ((count = batches.size()), ...);
+        pool.ParallelFor(count, grain, [&](std::size_t begin, std::size_t end) {
+            ExecuteBatch(batches.subspan(begin, end - begin)...);
+        });
+    }
+
+    // Same as above, with the default grain of the pool
+    void ExecuteParallel(ThreadPool& pool, std::span<std::remove_reference_t<Args>>... batches) const {
+        std::size_t count = 0;
+        ((count = batches.size()), ...);
+        ExecuteParallel(pool, pool.DefaultGrain(count), batches...);
+    }
+
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return m_segments.get_allocator().resource();
+    }
+
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // Returns the execution statistics of each block, indexed by the position of the block in the chain.
+    // Only Execute is measured. The immutable blocks shared with other chains share their statistics.
+    ChainReport Report() const {
+        ChainReport report;
+        for (const auto& segment : m_segments) {
+            const std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                report.blocks.push_back(entry.report(arena + entry.offset, report.blocks.size()));
+            }
+        }
+        return report;
+    }
+
+    // Resets the statistics of the blocks of the chain
+    void ResetReport() const noexcept {
+        for (const auto& segment : m_segments) {
+            std::byte* const arena = segment->arena.data();
+            for (const auto& entry : segment->dispatch) {
+                entry.reset_report(arena + entry.offset);
+            }
+        }
+    }
+#endif
+
+    // Calls fn on the action of each block of type Action, in order, e.g. to read or reset the state of the
+    // actions. The actions of the immutable blocks, which may be shared with other chains, are passed as const.
+    // The actions of a BlockTuple block are not visited.
+    template <class Action, class F>
+    void Visit(F&& fn) {
+        using Block_t = ExecutionBlock<Action>;
+        for (const auto& segment : m_segments) {
+            const detail::BlockArena& arena = segment->arena;
+            for (std::size_t i = 0; i < arena.count(); ++i) {
+                if (&arena.lifetime(i) == &detail::block_lifetime_v<Block_t>) {
+                    fn(Block_t::stored_action(arena.data() + arena.offset(i)));
+                }
+            }
+        }
+    }
+
+    template <class Action, class F>
+    void Visit(F&& fn) const {
+        const_cast<BasicExecutionChain&>(*this).template Visit<Action>([&](const Action& action) { fn(action); });
+    }
+
+    // Returns an immutable copy of the chain, stored and executed as a flat program (see FrozenChain)
+    BasicFrozenChain<Policy, Args...> freeze() const {
+        return BasicFrozenChain<Policy, Args...>(m_segments);
+    }
+
+    // Returns the bytes held by each block, the bookkeeping of the chain and the capacity its allocations
+    // hold for the blocks to come (see MemoryUsage)
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.segments = m_segments.size();
+        usage.overhead = m_segments.size() * (sizeof(SegmentPtr_t) + sizeof(Segment));
+        usage.slack = (m_segments.capacity() - m_segments.size()) * sizeof(SegmentPtr_t);
+        for (const auto& segment : m_segments) {
+            const detail::BlockArena& arena = segment->arena;
+            const bool shared = segment.use_count() > 1;
+            std::size_t end = 0;
+            for (std::size_t i = 0; i < arena.count(); ++i) {
+                const detail::BlockLifetime& lifetime = arena.lifetime(i);
+                const std::size_t padding = arena.offset(i) - end;
+                const BlockMemory block{ usage.blocks.size(), lifetime.type, lifetime.size,
+                                         sizeof(DispatchEntry) + detail::BlockArena::record_size() + padding, shared };
+                end = arena.offset(i) + lifetime.size;
+                usage.actions += block.size;
+                usage.overhead += block.overhead;
+                usage.blocks.push_back(block);
+            }
+            usage.slack += arena.capacity() - arena.size()
+                + (arena.record_capacity() - arena.count()) * detail::BlockArena::record_size()
+                + (segment->dispatch.capacity() - segment->dispatch.size()) * sizeof(DispatchEntry);
+        }
+        return usage;
+    }
+
+    // Moves every block in a single segment allocated to the exact size of the blocks : the chain is executed
+    // from one contiguous buffer, and holds no slack. The blocks of the segments shared with other chains are
+    // copied : the chain does not share its blocks anymore, and its copies copy all of them if one is stateful.
+    // Throws bad_block_copy, before modifying any block, if a block which must be copied is not copyable.
+    // If a block throws while being copied, the moved blocks are moved back : the chain is unchanged.
+    void compact() {
+        if (m_segments.empty() || (m_segments.size() == 1 && m_segments.capacity() == 1 && is_compact(m_segments.front()))) {
+            return;
+        }
+
+        std::size_t bytes = 0;
+        std::size_t align = 1;
+        std::size_t count = 0;
+        bool stateful = false;
+        bool copyable = true;
+        for (const auto& segment : m_segments) {
+            const detail::BlockArena& arena = segment->arena;
+            for (std::size_t i = 0; i < arena.count(); ++i) {
+                const detail::BlockLifetime& lifetime = arena.lifetime(i);
+                if (!lifetime.copyable && !is_moved_by_compact(segment, i)) {
+                    throw bad_block_copy{};
+                }
+                bytes = detail::align_up(bytes, lifetime.align) + lifetime.size;
+                align = std::max(align, lifetime.align);
+                copyable = copyable && lifetime.copyable;
+            }
+            count += arena.count();
+            stateful = stateful || segment->stateful;
+        }
+
+        SegmentPtr_t compacted = make_segment(stateful, resource());
+        compacted->copyable = copyable;
+        compacted->arena.reserve(bytes, align, count);
+        compacted->dispatch.reserve(count);
+        std::pmr::vector<SegmentPtr_t> segments(resource());
+        segments.reserve(1);
+
+        try {
+            for (const auto& segment : m_segments) {
+                detail::BlockArena& arena = segment->arena;
+                for (std::size_t i = 0; i < arena.count(); ++i) {
+                    DispatchEntry entry = segment->dispatch[i];
+                    entry.offset = is_moved_by_compact(segment, i) ? compacted->arena.relocate_from(arena, i)
+                                                                   : compacted->arena.copy_from(arena, i);
+                    compacted->dispatch.push_back(entry);
+                }
+            }
+        }
+        catch (...) {
+            undo_compact(compacted->arena);
+            throw;
+        }
+
+        segments.push_back(std::move(compacted));
+        m_segments.swap(segments);
+    }
+
+    // The foldable actions are appended as their fold, the NoOp actions are dropped
     template <class ActionT,
               enable_if_not_block_tuple<ActionT> = true,
               enable_if_not_chain<ActionT> = true>
-    ExecutionChain& append(ActionT&& action) {
-        m_blocks.emplace_back(create_block(action));
+    BasicExecutionChain& append(ActionT&& action) {
+        if constexpr (detail::foldable<std::decay_t<ActionT>>) {
+            return append(detail::fold(std::decay_t<ActionT>(std::forward<ActionT>(action))));
+        }
+        else if constexpr (!std::is_same_v<std::decay_t<ActionT>, NoOp>) {
+            create_block(std::forward<ActionT>(action));
+        }
         return *this;
     }
 
     template <class BlockTupleT, enable_if_compatible_block_tuple<BlockTupleT> = true>
-    ExecutionChain& append(BlockTupleT&& action) {
-        m_blocks.emplace_back(create_block(action));
+    BasicExecutionChain& append(BlockTupleT&& action) {
+        create_block(std::forward<BlockTupleT>(action));
         return *this;
     }
 
+    // Appends the blocks of the chains, the blocks of rvalue chains are moved
     template<class... RhsT, enable_if_chains<RhsT...> = true>
-    ExecutionChain& append(RhsT&&... rhs)
+    BasicExecutionChain& append(RhsT&&... rhs)
     {
-        (m_blocks.insert(m_blocks.end(), rhs.m_blocks.begin(), rhs.m_blocks.end()), ...);
+        (append_blocks(std::forward<RhsT>(rhs)), ...);
         return *this;
     }
 
     template<class BlockTupleT, enable_if_compatible_block_tuple<BlockTupleT> = true>
-    ExecutionChain& operator|=(BlockTupleT&& handler)
+    BasicExecutionChain& operator|=(BlockTupleT&& handler)
     {
         CheckBlockTupleCompatibility(handler);
-        append(handler);
+        append(std::forward<BlockTupleT>(handler));
         return *this;
     }
 
     template<class BlockTupleT, enable_if_compatible_block_tuple<BlockTupleT> = true>
-    ExecutionChain& operator=(BlockTupleT&& handler)
+    BasicExecutionChain& operator=(BlockTupleT&& handler)
     {
         CheckBlockTupleCompatibility(handler);
-        m_blocks.clear();
-        return this->operator|=(handler);
+        clear();
+        return this->operator|=(std::forward<BlockTupleT>(handler));
     }
 
 private:
     template<class... ActionsT>
-    constexpr static void CheckBlockTupleCompatibility(BlockTuple<ActionsT...>&)
+    constexpr static void CheckBlockTupleCompatibility(const BlockTuple<ActionsT...>&)
     {
         // because of the enable_if, this assertion won't fail
         // keep it to prevent the removal of the enable_if
@@ -227,182 +600,125 @@ private:
     }
 
     template <class ActionT>
-    static auto create_block(ActionT&& action)
+    void create_block(ActionT&& action)
     {
-        return std::make_unique<ExecutionBlock<std::decay_t<ActionT>>>(std::forward<ActionT>(action));
+        using Block_t = ExecutionBlock<std::decay_t<ActionT>>;
+        constexpr bool stateful = !Block_t::is_immutable;
+        constexpr bool copyable = std::is_copy_constructible_v<Block_t>;
+        Segment& segment = writable_segment(stateful, copyable);
+        reserve_dispatch(segment.dispatch, segment.dispatch.size() + 1);
+        const std::size_t offset = segment.arena.template emplace<Block_t>(std::forward<ActionT>(action));
+#if EXECUTION_CHAIN_INSTRUMENTATION
+        segment.dispatch.push_back({ &Block_t::Execute, offset, &Block_t::ExecuteBatch, &Block_t::ExecuteIncremental,
+                                     &Block_t::Report, &Block_t::ResetReport });
+#else
+        segment.dispatch.push_back({ &Block_t::Execute, offset, &Block_t::ExecuteBatch, &Block_t::ExecuteIncremental });
+#endif
+        segment.stateful = segment.stateful || stateful;
+        segment.copyable = segment.copyable && copyable;
     }
 
-    ExecutionBlockList_t m_blocks;
-};
-
-/**
- * \brief BlockTuple builds a compile-time list of actions. <br>
- * Therefore there is no indirection when passing from action to the next one. <br>
- * The BlockTuple can be executed as such or moved to an ExecutionChain
- * Compared to an ExecutionChain, the BlockTuple exposes the list of actions
- * instead of the list of types expected for execution. <br>
- * As a consequence, the BlockTuple can be executed with all the () overloads supported
- * by the ActionsT. <br>
- * For instance, the class below is invocable both with an int and a std::string :
- * \code{.cpp}
- * struct MyAction { void operator()(int); void operator()(std::string); };
- * auto handler = start_chain | MyAction{} | MyAction{}; // repeats MyAction
- * \endcode
- * Therefore, BlockTuple<MyAction> handler can be used as :
- * \code{.cpp}
- * handler(int{5}); // with an int
- * handler("Coucou"); // with a std::string
- * // Because of MyAction, both of the above calls are valid.
- * \endcode
-*/
-template <class... ActionsT>
-class BlockTuple
-{
-    using ActionTuple_t = std::tuple<ActionsT...>;
-public:
-    template<class... OtherActionsT, enable_if_not_block_tuple<OtherActionsT...> = true>
-    constexpr explicit BlockTuple(OtherActionsT&&... actions) : m_actions(actions...) {}
-
-    BlockTuple(const BlockTuple&) = default;
-    BlockTuple(BlockTuple&&) = default;
-
-    template<class... ArgsT>
-    struct are_actions_invocable;
-
-    template<template<class...> class BlockTupleT, class... Actions, class... ArgsT>
-    struct are_actions_invocable<BlockTupleT<Actions...>, ArgsT...>
-        : std::conjunction<std::is_invocable<Actions, ArgsT&...>...> {};
-
-    template <class... ArgsT,
-              std::enable_if_t<are_actions_invocable<
-                    const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
-    constexpr void Execute(ArgsT&&... args) const
+    // Shares the immutable segments of rhs and copies its stateful ones
+    void append_blocks(const BasicExecutionChain& rhs)
     {
-        std::apply([&](auto&&... actions)
-        {
-            (std::invoke(std::forward<decltype(actions)>(actions), std::forward<ArgsT>(args)...), ...);
-        }, m_actions);
+        const bool shareable = *resource() == *rhs.resource();
+        // rhs may be *this : iterate over the original count only
+        const std::size_t count = rhs.m_segments.size();
+        m_segments.reserve(m_segments.size() + count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const SegmentPtr_t& segment = rhs.m_segments[i];
+            m_segments.push_back(shareable && !segment->stateful ? segment : make_segment(*segment, resource()));
+        }
     }
 
-    template <class... ArgsT,
-              std::enable_if_t<are_actions_invocable<
-                    BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
-    constexpr void Execute(ArgsT&&... args)
+    // Splices the segments of rhs, nothing is copied
+    void append_blocks(BasicExecutionChain&& rhs)
     {
-        std::apply([&](auto&&... actions)
-        {
-            (std::invoke(std::forward<decltype(actions)>(actions), std::forward<ArgsT>(args)...), ...);
-        }, m_actions);
+        if (&rhs == this || *resource() != *rhs.resource()) {
+            append_blocks(static_cast<const BasicExecutionChain&>(rhs));
+            return;
+        }
+        m_segments.insert(m_segments.end(), std::make_move_iterator(rhs.m_segments.begin()),
+                          std::make_move_iterator(rhs.m_segments.end()));
+        rhs.m_segments.clear();
     }
 
-    template <class... ArgsT,
-              std::enable_if_t<are_actions_invocable<
-                  const BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
-    constexpr void operator()(ArgsT&&... args) const
+    // Returns the last segment if the chain is its only owner and the block may join it, a new segment
+    // otherwise. A block of the other kind only joins a segment when both are copyable : the copies of the
+    // chain copy the whole segment once it is stateful, and must not lose the immutable move-only blocks
+    // they could share.
+    Segment& writable_segment(bool stateful, bool copyable)
     {
-        Execute(std::forward<ArgsT>(args)...);
+        if (m_segments.empty() || m_segments.back().use_count() != 1 ||
+            (m_segments.back()->stateful != stateful && !(m_segments.back()->copyable && copyable))) {
+            m_segments.push_back(make_segment(stateful, resource()));
+        }
+        return *m_segments.back();
     }
 
-    template <class... ArgsT,
-              std::enable_if_t<are_actions_invocable<
-                  BlockTuple<ActionsT...>, ArgsT...>::value, bool> = true>
-    constexpr void operator()(ArgsT&&... args)
+    template <class... Ts>
+    SegmentPtr_t make_segment(Ts&&... args) const
     {
-        Execute(std::forward<ArgsT>(args)...);
+        return std::allocate_shared<Segment>(std::pmr::polymorphic_allocator<Segment>(resource()),
+                                             std::forward<Ts>(args)...);
     }
 
-    template <class... OtherActions>
-    constexpr BlockTuple<ActionsT..., OtherActions...> operator|(BlockTuple<OtherActions...> other)
+    // compact moves the blocks which cannot throw while moved, out of the segments owned by the chain only.
+    // The other blocks are copied : their source is left untouched.
+    static bool is_moved_by_compact(const SegmentPtr_t& segment, std::size_t index) noexcept
     {
-        return BlockTuple<ActionsT..., OtherActions...>(std::tuple_cat(m_actions, other.m_actions));
+        return segment.use_count() == 1 && segment->arena.lifetime(index).nothrow_relocatable;
     }
 
-    template <class OtherActionT
-             , std::enable_if_t<!is_block_tuple_v<OtherActionT>, bool> = true
-    >
-    constexpr BlockTuple<ActionsT..., OtherActionT> operator|(OtherActionT&& other)
+    // Moves back the blocks moved by a compact which failed, in the order they were stored in `compacted`
+    void undo_compact(detail::BlockArena& compacted) noexcept
     {
-        return std::apply(
-            [](ActionsT&&... actions, OtherActionT&& otherAction) -> BlockTuple<ActionsT..., OtherActionT>
-            {
-                return BlockTuple<ActionsT..., OtherActionT>{ actions..., otherAction };
-            },
-            std::tuple_cat(
-                m_actions,
-                std::forward_as_tuple<OtherActionT>(std::forward<OtherActionT>(other))
-            )
-        );
-    }
-
-    template <class OtherActionT
-             , std::enable_if_t<!is_block_tuple_v<OtherActionT>, bool> = true
-    >
-    constexpr BlockTuple<ActionsT..., OtherActionT> operator|(OtherActionT& other)
-    {
-        return std::apply(
-            [](ActionsT&&... actions, const OtherActionT& otherAction) -> BlockTuple<ActionsT..., OtherActionT>
-            {
-                return BlockTuple<ActionsT..., OtherActionT>{ actions..., otherAction };
-            },
-            std::tuple_cat(
-                m_actions,
-                std::forward_as_tuple<OtherActionT>(std::forward<OtherActionT>(other))
-            )
-        );
+        std::size_t stored = 0;
+        for (const auto& segment : m_segments) {
+            detail::BlockArena& arena = segment->arena;
+            for (std::size_t i = 0; i < arena.count() && stored < compacted.count(); ++i, ++stored) {
+                if (is_moved_by_compact(segment, i)) {
+                    const detail::BlockLifetime& lifetime = arena.lifetime(i);
+                    std::byte* const source = arena.data() + arena.offset(i);
+                    lifetime.destroy(source);
+                    lifetime.relocate(compacted.data() + compacted.offset(stored), source);
+                }
+            }
+        }
     }
 
-private:
-    ActionTuple_t m_actions;
-};
-
-template <>
-class BlockTuple<void>
-{
-public:
-    template <class... OtherActions>
-    constexpr BlockTuple<OtherActions...> operator|(BlockTuple<OtherActions...> other) const
+    // The segment is owned by the chain only, and its allocations hold its blocks only
+    static bool is_compact(const SegmentPtr_t& segment) noexcept
     {
-        return BlockTuple<OtherActions...>(other.m_actions);
+        const detail::BlockArena& arena = segment->arena;
+        return segment.use_count() == 1 && arena.capacity() == arena.size() && arena.record_capacity() == arena.count()
+            && segment->dispatch.capacity() == segment->dispatch.size();
     }
 
-    template <class OtherActionT
-        , std::enable_if_t<!is_block_tuple_v<OtherActionT>, bool> = true
-    >
-    constexpr BlockTuple<OtherActionT> operator|(OtherActionT&& other) const
+    // Reserved before a block is placed in the arena, so that registering it cannot throw
+    static void reserve_dispatch(DispatchTable_t& dispatch, std::size_t count)
     {
-        return BlockTuple<OtherActionT>{ other };
+        if (count > dispatch.capacity()) {
+            dispatch.reserve(std::max(count, 2 * dispatch.capacity()));
+        }
     }
 
-    template <class OtherActionT
-        , std::enable_if_t<!is_block_tuple_v<OtherActionT>, bool> = true
-    >
-    constexpr BlockTuple<std::decay_t<OtherActionT>> operator|(OtherActionT& other) const
+    void clear() noexcept
     {
-        return BlockTuple<std::decay_t<OtherActionT>>{ other };
+        m_segments.clear();
     }
-};
 
-template<class... Actions>
-BlockTuple(Actions...) -> BlockTuple<Actions...>;
-
-// Call this function to kick off the definition of an execution chain
-// Usage : auto blockTuple = start_chain | Action1{} | Action2{};
-static inline constexpr auto start_chain =  BlockTuple<void>{};
+    std::pmr::vector<SegmentPtr_t> m_segments;
+};
 
 template<class LhsT, class... RhsT,
          enable_if_chains<LhsT, RhsT...> = true
 >
 static auto operator|(LhsT&& lhs, RhsT&&... rhs)
 {
-    auto output = lhs;
-    output.append(rhs...);
+    std::decay_t<LhsT> output = std::forward<LhsT>(lhs);
+    output.append(std::forward<RhsT>(rhs)...);
     return output;
 }
 
-namespace ChainStep
-{
-    struct LogicFlow {};
-};
-
 } // namespace chain
-
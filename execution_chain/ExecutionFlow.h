@@ -1,42 +1,147 @@
 #pragma once
 
 #include "ExecutionChain.h"
+#include "Instrumentation.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stop_token>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <variant>
 
 namespace chain
 {
 
-namespace detail {
+namespace detail
+{
+
+// A predicate known at compile time : If(std::true_type{}) or If(std::bool_constant<Flag>{})
+template<class Predicate>
+inline constexpr bool is_constant_predicate_v = false;
 
-template<class T, class... Args>
-static inline constexpr bool returns_bool = std::is_same_v<bool, std::invoke_result_t<T, Args&...>>;
+template<bool B>
+inline constexpr bool is_constant_predicate_v<std::bool_constant<B>> = true;
 
-template<class Callable, class... Args>
-constexpr bool Call(Callable&& callable, Args&&... args)
+template<class Predicate, class... Args>
+constexpr bool test(const Predicate& predicate, Args&... args)
 {
-    if constexpr (returns_bool<std::decay_t<Callable>, Args...>)
+    if constexpr (is_constant_predicate_v<Predicate>)
     {
-        return callable(args...);
+        return Predicate::value;
     }
     else
     {
-        callable(args...);
-        return true;
+        return predicate(args...);
+    }
+}
+
+// Number of lanes processed at once by a batched If : the mask and the lane indices live on the stack
+inline constexpr std::size_t batch_chunk = 256;
+
+// Sets mask[i] to 1 if the predicate holds for the i-th lane, 0 otherwise. A predicate may provide a batch
+// overload predicate(std::span<Ts>..., std::span<std::uint8_t> mask), e.g. written with std::experimental::simd :
+// it sets mask[i] to any nonzero value for a lane which holds.
+template<class Predicate, class... Ts>
+void evaluate_mask(const Predicate& predicate, std::span<std::uint8_t> mask, std::span<Ts>... lanes)
+{
+    if constexpr (is_constant_predicate_v<Predicate>)
+    {
+        std::fill(mask.begin(), mask.end(), std::uint8_t{ Predicate::value });
+    }
+    else if constexpr (std::is_invocable_v<const Predicate&, std::span<Ts>..., std::span<std::uint8_t>>)
+    {
+        predicate(lanes..., mask);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < mask.size(); ++i)
+        {
+            mask[i] = static_cast<std::uint8_t>(static_cast<bool>(predicate(lanes[i]...)));
+        }
     }
 }
+
+// Runs the branch on the selected lanes. A branch may provide an overload
+// branch(std::span<Ts>..., std::span<const std::uint32_t> selected) receiving the indices of the lanes.
+template<class Branch, class... Ts>
+void execute_lanes(Branch& branch, std::span<const std::uint32_t> selected, std::span<Ts>... lanes)
+{
+    if constexpr (std::is_invocable_v<Branch&, std::span<Ts>..., std::span<const std::uint32_t>>)
+    {
+        std::invoke(branch, lanes..., selected);
+    }
+    else
+    {
+        for (const std::uint32_t lane : selected)
+        {
+            std::invoke(branch, lanes[lane]...);
+        }
+    }
+}
+
+// Executes then_ on the contexts for which the predicate holds, and else_ (unless null) on the other ones.
+// The batch is processed by chunks : the predicate is evaluated on the whole chunk into a mask, whose lanes
+// are compacted into the indices of each branch without branching on the mask.
+template<class Predicate, class Then, class Else, class... Ts>
+void execute_masked(const Predicate& predicate, Then& then_, Else* else_, std::span<Ts>... batches)
+{
+    std::size_t count = 0;
+    ((count = batches.size()), ...);
+
+    std::array<std::uint8_t, batch_chunk> mask;
+    std::array<std::uint32_t, batch_chunk> selected;
+    std::array<std::uint32_t, batch_chunk> others;
+    for (std::size_t begin = 0; begin < count; begin += batch_chunk)
+    {
+        const std::size_t size = std::min(batch_chunk, count - begin);
+        evaluate_mask(predicate, std::span<std::uint8_t>(mask.data(), size), batches.subspan(begin, size)...);
+
+        std::size_t selectedCount = 0;
+        std::size_t otherCount = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            selected[selectedCount] = static_cast<std::uint32_t>(i);
+            others[otherCount] = static_cast<std::uint32_t>(i);
+            // a batch predicate may set any nonzero byte for a selected lane, e.g. 0xFF from a simd mask
+            const std::size_t bit = mask[i] != 0;
+            selectedCount += bit;
+            otherCount += 1u - bit;
+        }
+
+        execute_lanes(then_, std::span<const std::uint32_t>(selected.data(), selectedCount),
+                      batches.subspan(begin, size)...);
+        if (else_)
+        {
+            execute_lanes(*else_, std::span<const std::uint32_t>(others.data(), otherCount),
+                          batches.subspan(begin, size)...);
+        }
+    }
 }
 
+} // namespace detail
+
 template<class If_t, class Then_t, class Else_t>
 struct IfThenElse : ChainStep::LogicFlow
 {
     template<class... Args>
     constexpr bool Execute(Args&... args) const
     {
-        if (m_predicate(args...))
+        if (detail::test(m_predicate, args...))
         {
+            m_branches.take_primary();
             return detail::Call(m_then, args...);
         }
 
+        m_branches.take_alternative();
         return detail::Call(m_elseThen, args...);
     }
 
@@ -46,18 +151,59 @@ struct IfThenElse : ChainStep::LogicFlow
         return Execute(args...);
     }
 
+    // Executed over a batch of contexts (see ExecuteBatch), the predicate is evaluated into a mask and each
+    // branch runs over the lanes it selected, instead of branching on each context (see detail::execute_masked).
+    // The predicate is evaluated on a chunk of contexts before the branches run on them.
+    template<class... Ts>
+        requires std::is_invocable_v<const Then_t&, Ts&...> && std::is_invocable_v<const Else_t&, Ts&...>
+    void operator()(std::span<Ts>... batches) const
+    {
+        detail::execute_masked(std::as_const(m_predicate), m_then, &m_elseThen, batches...);
+    }
+
+    // With a constant predicate, the step is replaced by the selected branch when it is appended to a chain
+    constexpr auto Fold() && requires detail::is_constant_predicate_v<std::remove_cvref_t<If_t>>
+    {
+        if constexpr (std::remove_cvref_t<If_t>::value)
+        {
+            return std::decay_t<Then_t>(std::forward<Then_t>(m_then));
+        }
+        else
+        {
+            return std::decay_t<Else_t>(std::forward<Else_t>(m_elseThen));
+        }
+    }
+
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // How often each branch was taken
+    BranchReport Branches() const noexcept
+    {
+        return m_branches.report();
+    }
+
+    void ResetReport() const noexcept
+    {
+        m_branches.reset();
+    }
+#endif
+
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<If_t, Then_t, Else_t>>;
+
 private:
     constexpr IfThenElse(If_t&& pred,
         Then_t&& then_,
         Else_t&& else_)
-        : m_predicate(pred)
-        , m_then(then_)
-        , m_elseThen(else_)
+        : m_predicate(std::forward<If_t>(pred))
+        , m_then(std::forward<Then_t>(then_))
+        , m_elseThen(std::forward<Else_t>(else_))
     {}
 
     If_t m_predicate;
     Then_t m_then;
     Else_t m_elseThen;
+    // empty when the instrumentation is disabled
+    [[no_unique_address]] mutable detail::BranchProfile m_branches;
 
     template<class I, class T>
     friend struct IfThen;
@@ -69,11 +215,13 @@ struct IfThen : ChainStep::LogicFlow
     template<class... Args>
     constexpr bool Execute(Args&... args) const
     {
-        if (!m_predicate(args...))
+        if (!detail::test(m_predicate, args...))
         {
+            m_branches.take_alternative();
             return true; // continue
         }
 
+        m_branches.take_primary();
         return detail::Call(m_then, args...);
     }
 
@@ -83,6 +231,28 @@ struct IfThen : ChainStep::LogicFlow
         return Execute(args...);
     }
 
+    // Executed over a batch of contexts, the branch runs over the lanes selected by the mask of the predicate
+    // (see IfThenElse)
+    template<class... Ts>
+        requires std::is_invocable_v<const Then_t&, Ts&...>
+    void operator()(std::span<Ts>... batches) const
+    {
+        detail::execute_masked(std::as_const(m_predicate), m_then, static_cast<const NoOp*>(nullptr), batches...);
+    }
+
+    // With a constant predicate, the step is replaced by its branch, or dropped, when it is appended to a chain
+    constexpr auto Fold() && requires detail::is_constant_predicate_v<std::remove_cvref_t<If_t>>
+    {
+        if constexpr (std::remove_cvref_t<If_t>::value)
+        {
+            return std::decay_t<Then_t>(std::forward<Then_t>(m_then));
+        }
+        else
+        {
+            return NoOp{};
+        }
+    }
+
     template<class Else_t>
     constexpr auto Else(Else_t&& elseThen)
     {
@@ -93,24 +263,46 @@ struct IfThen : ChainStep::LogicFlow
         };
     }
 
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // How often each branch was taken
+    BranchReport Branches() const noexcept
+    {
+        return m_branches.report();
+    }
+
+    void ResetReport() const noexcept
+    {
+        m_branches.reset();
+    }
+#endif
+
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<If_t, Then_t>>;
+
 private:
     constexpr IfThen(If_t&& pred,
         Then_t&& then_)
-        : m_predicate(pred)
-        , m_then(then_)
+        : m_predicate(std::forward<If_t>(pred))
+        , m_then(std::forward<Then_t>(then_))
     {}
 
     If_t m_predicate;
     Then_t m_then;
+    // empty when the instrumentation is disabled
+    [[no_unique_address]] mutable detail::BranchProfile m_branches;
 
     template<class I>
     friend struct If;
+
+    // evaluates the predicate and the branch separately
+    template<class... Cases>
+    friend struct FirstOf;
 };
 
 template<class If_t>
 struct If
 {
-    constexpr If(If_t&& logic) : m_logic(logic) {}
+    constexpr If(If_t&& logic) : m_logic(std::forward<If_t>(logic)) {}
 
     template<class Then_t>
     constexpr auto Then(Then_t&& then)
@@ -128,10 +320,42 @@ private:
 template<class Try_t, class Fallback_t>
 struct TryFallback : ChainStep::LogicFlow
 {
+    // When the try returns a Result (or an expected value), its error is given to the fallback taking it as
+    // first argument, e.g. Fallback([](const ParseError& error, Request& r) { ... }), and is dropped otherwise :
+    // the fallback handled the failure, it is not raised to the ErrorChannel of the execution.
     template<class... Args>
     constexpr bool Execute(Args&... args)
     {
-        return detail::Call(m_try, args...) || detail::Call(m_fallback, args...);
+        if constexpr (detail::expected_like<std::invoke_result_t<Try_t&, Args&...>>)
+        {
+            auto&& result = std::invoke(m_try, args...);
+            if (result.has_value())
+            {
+                m_branches.take_primary();
+                return true;
+            }
+
+            m_branches.take_alternative();
+            if constexpr (std::is_invocable_v<Fallback_t&, decltype(result.error()), Args&...>)
+            {
+                return detail::Call(m_fallback, result.error(), args...);
+            }
+            else
+            {
+                return detail::Call(m_fallback, args...);
+            }
+        }
+        else
+        {
+            if (detail::Call(m_try, args...))
+            {
+                m_branches.take_primary();
+                return true;
+            }
+
+            m_branches.take_alternative();
+            return detail::Call(m_fallback, args...);
+        }
     }
 
     template<class... Args>
@@ -140,6 +364,22 @@ struct TryFallback : ChainStep::LogicFlow
         return Execute(args...);
     }
 
+#if EXECUTION_CHAIN_INSTRUMENTATION
+    // How often each branch was taken
+    BranchReport Branches() const noexcept
+    {
+        return m_branches.report();
+    }
+
+    void ResetReport() const noexcept
+    {
+        m_branches.reset();
+    }
+#endif
+
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Try_t, Fallback_t>>;
+
 private:
     constexpr TryFallback(Try_t&& try_, Fallback_t&& fallback)
         : m_try(try_)
@@ -148,6 +388,8 @@ private:
 
     Try_t m_try;
     Fallback_t m_fallback;
+    // empty when the instrumentation is disabled
+    [[no_unique_address]] mutable detail::BranchProfile m_branches;
 
     template<class T>
     friend struct Try;
@@ -170,4 +412,1202 @@ struct Try
     Try_t m_try;
 };
 
-} // namespace chain
\ No newline at end of file
+/**
+ * \brief Project(projection, action) executes the action on a part of the first argument, given by reference :
+ * action(std::invoke(projection, first), others...). The projection is a pointer to a data member, or a callable
+ * returning a reference. The actions can then be written against the narrow types they use, without copies
+ * nor wrapping lambdas.
+ * \code{.cpp}
+ *    ExecutionChain<Race&> chain = start_chain
+ *        | Project(&Race::m_myPods, [](std::vector<Pod>& pods) { ... })
+ *        | Project(&Race::m_checkpoints, Log());
+ * \endcode
+*/
+template<class Projection_t, class Action_t>
+struct ProjectStep : ChainStep::LogicFlow
+{
+    template<class First, class... Args>
+        requires std::is_invocable_v<const Action_t&, std::invoke_result_t<const Projection_t&, First&>, Args&...>
+    constexpr bool Execute(First& first, Args&... args) const
+    {
+        return Run(*this, first, args...);
+    }
+
+    template<class First, class... Args>
+        requires std::is_invocable_v<Action_t&, std::invoke_result_t<const Projection_t&, First&>, Args&...>
+    constexpr bool Execute(First& first, Args&... args)
+    {
+        return Run(*this, first, args...);
+    }
+
+    template<class First, class... Args>
+        requires std::is_invocable_v<const Action_t&, std::invoke_result_t<const Projection_t&, First&>, Args&...>
+    constexpr bool operator()(First& first, Args&... args) const
+    {
+        return Execute(first, args...);
+    }
+
+    template<class First, class... Args>
+        requires std::is_invocable_v<Action_t&, std::invoke_result_t<const Projection_t&, First&>, Args&...>
+    constexpr bool operator()(First& first, Args&... args)
+    {
+        return Execute(first, args...);
+    }
+
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Projection_t, Action_t>>;
+
+    Projection_t m_projection;
+    Action_t m_action;
+
+private:
+    template<class Self, class First, class... Args>
+    static constexpr bool Run(Self& self, First& first, Args&... args)
+    {
+        static_assert(std::is_lvalue_reference_v<std::invoke_result_t<const Projection_t&, First&>>,
+            "Project : the projection must return a reference to a part of the argument, not a copy");
+        decltype(auto) part = std::invoke(std::as_const(self.m_projection), first);
+        return detail::Call(self.m_action, part, args...);
+    }
+};
+
+template<class ProjectionT, class ActionT>
+constexpr auto Project(ProjectionT&& projection, ActionT&& action)
+{
+    return ProjectStep<std::decay_t<ProjectionT>, std::decay_t<ActionT>>{
+        {}, std::forward<ProjectionT>(projection), std::forward<ActionT>(action) };
+}
+
+/**
+ * \brief Optional(action) is a block which may be skipped when the chain is executed with a deadline
+ * (see ExecutionChain::Execute(deadline, args...)) : it is executed only if the deadline did not expire yet.
+ * Otherwise, it is recorded as skipped by the deadline and does not stop the chain. <br>
+ * Without a deadline, the action is always executed.
+ * \code{.cpp}
+ *    ExecutionChain<Race&> chain = start_chain | Steer() | Optional(RefineTrajectory()) | Thrust();
+ *    Deadline deadline(std::chrono::milliseconds(45));
+ *    chain.Execute(deadline, race); // Thrust is executed even if the refinement was skipped
+ * \endcode
+*/
+template<class Action_t>
+struct OptionalStep : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Action_t>>;
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+    Action_t m_action;
+
+private:
+    template<class Self, class... Args>
+    static constexpr bool Run(Self& self, Args&... args)
+    {
+        if (Deadline* deadline = detail::current_deadline(); deadline && deadline->Expired())
+        {
+            deadline->RecordSkipped();
+            return true;
+        }
+        return detail::Call(self.m_action, args...);
+    }
+};
+
+template<class ActionT>
+constexpr auto Optional(ActionT&& action)
+{
+    return OptionalStep<std::decay_t<ActionT>>{ {}, std::forward<ActionT>(action) };
+}
+
+/**
+ * \brief Anytime(action) is an Optional block whose action polls the deadline to return early with its best
+ * result : the action is invoked with the deadline as a trailing argument, action(args..., deadline). <br>
+ * It is skipped if the deadline expired before it started, and recorded as interrupted if it returned after the
+ * expiration. Without a deadline, it gets a deadline which never expires.
+ * \code{.cpp}
+ *    auto search = Anytime([](Race& race, const Deadline& deadline) {
+ *        for (int depth = 1; !deadline.Expired(); ++depth) { race.plan = Search(race, depth); }
+ *    });
+ * \endcode
+*/
+template<class Action_t>
+struct AnytimeStep : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Action_t>>;
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&..., const Deadline&>
+    bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&..., const Deadline&>
+    bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&..., const Deadline&>
+    bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&..., const Deadline&>
+    bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+    Action_t m_action;
+
+private:
+    template<class Self, class... Args>
+    static bool Run(Self& self, Args&... args)
+    {
+        Deadline* deadline = detail::current_deadline();
+        if (!deadline)
+        {
+            static const Deadline never;
+            return detail::Call(self.m_action, args..., never);
+        }
+        if (deadline->Expired())
+        {
+            deadline->RecordSkipped();
+            return true;
+        }
+        const bool result = detail::Call(self.m_action, args..., std::as_const(*deadline));
+        if (deadline->Expired())
+        {
+            deadline->RecordInterrupted();
+        }
+        return result;
+    }
+};
+
+template<class ActionT>
+constexpr auto Anytime(ActionT&& action)
+{
+    return AnytimeStep<std::decay_t<ActionT>>{ {}, std::forward<ActionT>(action) };
+}
+
+namespace detail
+{
+
+// The number of repetitions of a Repeat step : N, or a count known at run time when N is 0
+template<std::size_t N>
+struct RepeatCount
+{
+    static constexpr std::size_t get() noexcept
+    {
+        return N;
+    }
+};
+
+template<>
+struct RepeatCount<0>
+{
+    constexpr std::size_t get() const noexcept
+    {
+        return count;
+    }
+
+    std::size_t count = 0;
+};
+
+} // namespace detail
+
+/**
+ * \brief Repeat<N>(action) executes the action N times, Repeat(count, action) count times. <br>
+ * As in a ShortCircuit chain, the repetitions stop at the first execution of the action returning false,
+ * and the step returns false. <br>
+ * The repetitions of Repeat<N> are unrolled at compile time, up to 16 of them. Repeat(count, action) is a
+ * RepeatStep<0, Action>.
+ * \code{.cpp}
+ *    ExecutionChain<Race&> chain = start_chain
+ *        | Repeat<4>(SimulateOneTurn())         // unrolled
+ *        | Repeat(depth, SimulateOneTurn());    // loop
+ * \endcode
+ * Executed over a batch of contexts (see ExecuteBatch), each repetition runs over the whole batch before the
+ * next one starts, using the batch overload of the action if it provides one. The results are then ignored.
+*/
+template<std::size_t N, class Action_t>
+struct RepeatStep : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Action_t>>;
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+    template<class... Ts>
+        requires std::is_invocable_v<const Action_t&, Ts&...>
+    constexpr void operator()(std::span<Ts>... batches) const
+    {
+        RunBatch(*this, batches...);
+    }
+
+    template<class... Ts>
+        requires std::is_invocable_v<Action_t&, Ts&...>
+    constexpr void operator()(std::span<Ts>... batches)
+    {
+        RunBatch(*this, batches...);
+    }
+
+    // empty when N is known at compile time
+    [[no_unique_address]] detail::RepeatCount<N> m_count;
+    Action_t m_action;
+
+private:
+    static constexpr std::size_t max_unrolled = 16;
+
+    template<class Self, class... Args>
+    static constexpr bool Run(Self& self, Args&... args)
+    {
+        if constexpr (N > 0 && N <= max_unrolled)
+        {
+            return [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return ((static_cast<void>(I), detail::Call(self.m_action, args...)) && ...);
+            }(std::make_index_sequence<N>{});
+        }
+        else
+        {
+            for (std::size_t i = 0; i < self.m_count.get(); ++i)
+            {
+                if (!detail::Call(self.m_action, args...))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    template<class Self, class... Ts>
+    static constexpr void RunBatch(Self& self, std::span<Ts>... batches)
+    {
+        for (std::size_t i = 0; i < self.m_count.get(); ++i)
+        {
+            detail::execute_batch(self.m_action, batches...);
+        }
+    }
+};
+
+template<std::size_t N, class ActionT>
+constexpr auto Repeat(ActionT&& action)
+{
+    static_assert(N > 0, "Repeat<N> : use Repeat(count, action) for a count known at run time");
+    return RepeatStep<N, std::decay_t<ActionT>>{ {}, {}, std::forward<ActionT>(action) };
+}
+
+template<class ActionT>
+constexpr auto Repeat(std::size_t count, ActionT&& action)
+{
+    return RepeatStep<0, std::decay_t<ActionT>>{ {}, { count }, std::forward<ActionT>(action) };
+}
+
+/**
+ * \brief While(predicate).Do(action) executes the action as long as the predicate holds. <br>
+ * The loop stops at the first execution of the action returning false, and the step returns false.
+ * The predicate is evaluated as const, before each execution of the action.
+ * \code{.cpp}
+ *    auto refine = While([](const Race& race) { return race.error > 0.01; }).Do(Refine());
+ * \endcode
+*/
+template<class Predicate_t, class Action_t>
+struct WhileDo : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Predicate_t, Action_t>>;
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+    Predicate_t m_predicate;
+    Action_t m_action;
+
+private:
+    template<class Self, class... Args>
+    static constexpr bool Run(Self& self, Args&... args)
+    {
+        while (std::as_const(self.m_predicate)(args...))
+        {
+            if (!detail::Call(self.m_action, args...))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template<class Predicate_t>
+struct While
+{
+    template<class PredicateT>
+    constexpr explicit While(PredicateT&& predicate) : m_predicate(std::forward<PredicateT>(predicate)) {}
+
+    template<class ActionT>
+    constexpr auto Do(ActionT&& action) &&
+    {
+        return WhileDo<Predicate_t, std::decay_t<ActionT>>{ {}, std::move(m_predicate), std::forward<ActionT>(action) };
+    }
+
+private:
+    Predicate_t m_predicate;
+};
+
+template<class PredicateT>
+While(PredicateT&&) -> While<std::decay_t<PredicateT>>;
+
+namespace detail
+{
+
+template<class Branch, class... Args>
+bool call_branch(Branch& branch, const std::stop_source& source, Args&... args)
+{
+    if constexpr (std::is_invocable_v<Branch&, Args&..., std::stop_token>)
+    {
+        return Call(branch, args..., source.get_token());
+    }
+    else
+    {
+        return Call(branch, args...);
+    }
+}
+
+// A branch of a fork/join step is called with the arguments, and possibly a trailing std::stop_token
+template<class Branch, class... Args>
+inline constexpr bool is_branch_invocable_v =
+    std::is_invocable_v<Branch, Args&...> || std::is_invocable_v<Branch, Args&..., std::stop_token>;
+
+template<class Branches, class... Args>
+inline constexpr bool accepts_stop_token_v = []<std::size_t... I>(std::index_sequence<I...>)
+{
+    return (std::is_invocable_v<decltype(std::get<I>(std::declval<Branches&>())), Args&..., std::stop_token> || ...);
+}(std::make_index_sequence<std::tuple_size_v<std::remove_const_t<Branches>>>{});
+
+// Runs the branches of a fork/join step (All, Any) on the pool and joins them.
+// on_result(result) is called for each executed branch, and returns false to cancel the other branches :
+// the branches which did not start are skipped, the running ones accepting a trailing std::stop_token see
+// the stop request. The stop state is only allocated when a branch can observe it.
+template<class Branches, class OnResult, class... Args>
+void fork_join(ThreadPool& pool, Branches& branches, OnResult&& on_result, Args&... args)
+{
+    constexpr std::size_t count = std::tuple_size_v<std::remove_const_t<Branches>>;
+    std::stop_source source = accepts_stop_token_v<Branches, Args...> ? std::stop_source{}
+                                                                      : std::stop_source{ std::nostopstate };
+    std::atomic<bool> cancelled{ false };
+    const auto run = [&](auto& branch)
+    {
+        if (!on_result(call_branch(branch, source, args...)))
+        {
+            cancelled.store(true, std::memory_order_relaxed);
+            source.request_stop();
+        }
+    };
+
+    pool.ParallelFor(count, 1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t index = begin; index < end && !cancelled.load(std::memory_order_relaxed); ++index)
+        {
+            [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                ((I == index ? run(std::get<I>(branches)) : void()), ...);
+            }(std::make_index_sequence<count>{});
+        }
+    });
+}
+
+} // namespace detail
+
+/**
+ * \brief All runs its branches concurrently on a thread pool and joins them before the chain continues. <br>
+ * It returns true if every branch returned true (branches returning void count as true).
+ * \code{.cpp}
+ *    ExecutionChain<Race&> chain = start_chain
+ *        | All(FindMyCollisions(), FindOtherCollisions()) // side by side
+ *        | Thrust();
+ * \endcode
+ * The branches share the arguments : they must not modify the same data. <br>
+ * The branches run on ThreadPool::Default() unless another pool is provided with On(pool).
+ * The calling thread runs a branch itself and helps the pool until every branch is done.
+ * An exception thrown by a branch is rethrown once all the branches are done.
+*/
+template<class... Branches_t>
+struct All : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Branches_t...>>;
+
+    template<class... BranchesT>
+    constexpr explicit All(BranchesT&&... branches) : m_branches(std::forward<BranchesT>(branches)...) {}
+
+    // Runs the branches on pool instead of the default pool
+    constexpr All&& On(ThreadPool& pool) &&
+    {
+        m_pool = &pool;
+        return std::move(*this);
+    }
+
+    // the step is immutable when its branches can be called as const
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<const Branches_t&, Args...> && ...)
+    bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<Branches_t&, Args...> && ...)
+    bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<const Branches_t&, Args...> && ...)
+    bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<Branches_t&, Args...> && ...)
+    bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+private:
+    template<class Self, class... Args>
+    static bool Run(Self& self, Args&... args)
+    {
+        std::atomic<bool> succeeded{ true };
+        detail::fork_join(self.pool(), self.m_branches, [&](bool result)
+        {
+            if (!result)
+            {
+                succeeded.store(false, std::memory_order_relaxed);
+            }
+            return true; // every branch runs
+        }, args...);
+        return succeeded.load(std::memory_order_relaxed);
+    }
+
+    ThreadPool& pool() const
+    {
+        return m_pool ? *m_pool : ThreadPool::Default();
+    }
+
+    std::tuple<Branches_t...> m_branches;
+    ThreadPool* m_pool = nullptr;
+};
+
+/**
+ * \brief Any runs its branches concurrently on a thread pool and returns true as soon as one of them succeeded
+ * (returned true, or void). <br>
+ * The success cancels the other branches : the branches which did not start are skipped, and the running
+ * branches accepting a trailing std::stop_token see the stop request. Any still joins every started branch
+ * before the chain continues.
+ * \code{.cpp}
+ *    ExecutionChain<Query&> chain = start_chain
+ *        | Any(LookupCache(), [](Query& q, std::stop_token token) { return LookupDatabase(q, token); })
+ *        | Reply();
+ * \endcode
+ * As for All, the branches share the arguments and run on ThreadPool::Default() unless On(pool) is used.
+*/
+template<class... Branches_t>
+struct Any : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Branches_t...>>;
+
+    template<class... BranchesT>
+    constexpr explicit Any(BranchesT&&... branches) : m_branches(std::forward<BranchesT>(branches)...) {}
+
+    // Runs the branches on pool instead of the default pool
+    constexpr Any&& On(ThreadPool& pool) &&
+    {
+        m_pool = &pool;
+        return std::move(*this);
+    }
+
+    // the step is immutable when its branches can be called as const
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<const Branches_t&, Args...> && ...)
+    bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<Branches_t&, Args...> && ...)
+    bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<const Branches_t&, Args...> && ...)
+    bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires (detail::is_branch_invocable_v<Branches_t&, Args...> && ...)
+    bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+private:
+    template<class Self, class... Args>
+    static bool Run(Self& self, Args&... args)
+    {
+        std::atomic<bool> succeeded{ false };
+        detail::fork_join(self.pool(), self.m_branches, [&](bool result)
+        {
+            if (result)
+            {
+                succeeded.store(true, std::memory_order_relaxed);
+            }
+            return !result; // the first success cancels the other branches
+        }, args...);
+        return succeeded.load(std::memory_order_relaxed);
+    }
+
+    ThreadPool& pool() const
+    {
+        return m_pool ? *m_pool : ThreadPool::Default();
+    }
+
+    std::tuple<Branches_t...> m_branches;
+    ThreadPool* m_pool = nullptr;
+};
+
+template<class... Branches>
+All(Branches&&...) -> All<std::decay_t<Branches>...>;
+
+template<class... Branches>
+Any(Branches&&...) -> Any<std::decay_t<Branches>...>;
+
+/**
+ * \brief FirstOf evaluates the predicates of its If(...).Then(...) cases in turn, and executes the Then branch of the
+ * first case whose predicate holds. It returns the result of that branch, true if no predicate holds.
+ * \code{.cpp}
+ *    ExecutionChain<Request&> router = start_chain
+ *        | FirstOf(If(IsStatic()).Then(ServeFile()),
+ *                  If(IsApi()).Then(CallApi()),
+ *                  If(IsWebSocket()).Then(Upgrade()))
+ *              .Adaptive(); // the most frequent cases are evaluated first
+ * \endcode
+ * With Adaptive(samplingInterval, reorderPeriod), one execution out of samplingInterval (a power of 2, per thread)
+ * counts a hit for the matching case, and after reorderPeriod sampled hits the cases are reordered by decreasing hit
+ * count. The counts are then halved, so that the order follows a changing mix of cases. <br>
+ * The predicates must not overlap, the order being otherwise observable. <br>
+ * The counters and the order are relaxed atomics : the step can be executed by several threads while it reorders,
+ * each execution evaluating every case once, in the order at its start. An adaptive FirstOf has at most 16 cases.
+*/
+template<class... Cases_t>
+struct FirstOf : ChainStep::LogicFlow
+{
+    static constexpr std::size_t case_count = sizeof...(Cases_t);
+    // the adaptive order is a state of each copy : the step is never shared by the copies of a chain
+    using shareable = std::false_type;
+
+    template<class... CasesT>
+        requires (!std::is_same_v<std::remove_cvref_t<CasesT>, FirstOf> && ...)
+    constexpr explicit FirstOf(CasesT&&... cases) : m_cases(std::forward<CasesT>(cases)...) {}
+
+    FirstOf(const FirstOf& other) requires (std::is_copy_constructible_v<Cases_t> && ...)
+        : m_cases(other.m_cases)
+        , m_adaptive(other.m_adaptive)
+        , m_samplingInterval(other.m_samplingInterval)
+        , m_reorderPeriod(other.m_reorderPeriod)
+        , m_order(other.m_order.load(std::memory_order_relaxed))
+    {
+        CopyHits(other);
+    }
+
+    // the cases are moved, the counters and the order copied
+    FirstOf(FirstOf&& other) noexcept((std::is_nothrow_move_constructible_v<Cases_t> && ...))
+        : m_cases(std::move(other.m_cases))
+        , m_adaptive(other.m_adaptive)
+        , m_samplingInterval(other.m_samplingInterval)
+        , m_reorderPeriod(other.m_reorderPeriod)
+        , m_order(other.m_order.load(std::memory_order_relaxed))
+    {
+        CopyHits(other);
+    }
+
+    // Counts the hits of the cases, and reorders them by frequency (see above)
+    FirstOf&& Adaptive(std::uint32_t samplingInterval = 16, std::uint32_t reorderPeriod = 1024) &&
+    {
+        static_assert(case_count <= 16, "An adaptive FirstOf has at most 16 cases");
+        assert(std::has_single_bit(samplingInterval) && reorderPeriod > 0);
+        m_adaptive = true;
+        m_samplingInterval = samplingInterval;
+        m_reorderPeriod = reorderPeriod;
+        return std::move(*this);
+    }
+
+    // Current evaluation order : the indices of the cases, as passed to FirstOf
+    std::array<std::size_t, case_count> Order() const noexcept
+    {
+        std::array<std::size_t, case_count> order{};
+        std::uint64_t packed = m_order.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < case_count; ++i, packed >>= 4)
+        {
+            order[i] = m_adaptive ? static_cast<std::size_t>(packed & 0xF) : i;
+        }
+        return order;
+    }
+
+    template<class... Args>
+        requires (std::is_invocable_v<const Cases_t&, Args&...> && ...)
+    bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (std::is_invocable_v<Cases_t&, Args&...> && ...)
+    bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires (std::is_invocable_v<const Cases_t&, Args&...> && ...)
+    bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires (std::is_invocable_v<Cases_t&, Args&...> && ...)
+    bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+private:
+    // the cases in the order they were passed, 4 bits per case
+    static constexpr std::uint64_t identity_order = []
+    {
+        std::uint64_t order = 0;
+        for (std::size_t i = case_count; i-- > 0;)
+        {
+            order = (order << 4) | (i & 0xF);
+        }
+        return order;
+    }();
+
+    // Executes the Then branch of the case I if its predicate holds, returns whether it did
+    template<std::size_t I, class Self, class... Args>
+    static bool TryCase(Self& self, bool& result, Args&... args)
+    {
+        auto& case_ = std::get<I>(self.m_cases);
+        if (!detail::test(case_.m_predicate, args...))
+        {
+            return false;
+        }
+        result = detail::Call(case_.m_then, args...);
+        return true;
+    }
+
+    template<class Self, class... Args>
+    static bool Run(Self& self, Args&... args)
+    {
+        bool result = true;
+        if (!self.m_adaptive)
+        {
+            [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                (TryCase<I>(self, result, args...) || ...);
+            }(std::index_sequence_for<Cases_t...>{});
+            return result;
+        }
+
+        std::uint64_t order = self.m_order.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < case_count; ++i, order >>= 4)
+        {
+            const auto index = static_cast<std::size_t>(order & 0xF);
+            const bool matched = [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return ((I == index && TryCase<I>(self, result, args...)) || ...);
+            }(std::index_sequence_for<Cases_t...>{});
+
+            if (matched)
+            {
+                self.Sample(index);
+                return result;
+            }
+        }
+        return result;
+    }
+
+    void CopyHits(const FirstOf& other) noexcept
+    {
+        for (std::size_t i = 0; i < case_count; ++i)
+        {
+            m_hits[i].store(other.m_hits[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    void Sample(std::size_t index) const noexcept
+    {
+        thread_local std::uint32_t t_executions = 0;
+        if ((++t_executions & (m_samplingInterval - 1)) != 0)
+        {
+            return;
+        }
+
+        m_hits[index].fetch_add(1, std::memory_order_relaxed);
+        // a single thread reaches the period and reorders
+        if (m_samples.fetch_add(1, std::memory_order_relaxed) + 1 == m_reorderPeriod)
+        {
+            Reorder();
+            m_samples.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Reorder() const noexcept
+    {
+        std::array<std::uint32_t, case_count> hits{};
+        std::array<std::size_t, case_count> order{};
+        for (std::size_t i = 0; i < case_count; ++i)
+        {
+            hits[i] = m_hits[i].load(std::memory_order_relaxed);
+            m_hits[i].store(hits[i] / 2, std::memory_order_relaxed);
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return hits[a] > hits[b]; });
+        std::uint64_t packed = 0;
+        for (std::size_t i = case_count; i-- > 0;)
+        {
+            packed = (packed << 4) | order[i];
+        }
+        m_order.store(packed, std::memory_order_relaxed);
+    }
+
+    std::tuple<Cases_t...> m_cases;
+    bool m_adaptive = false;
+    std::uint32_t m_samplingInterval = 16;
+    std::uint32_t m_reorderPeriod = 1024;
+
+    // the statistics are updated by executions of a const FirstOf
+    mutable std::atomic<std::uint64_t> m_order{ identity_order };
+    mutable std::array<std::atomic<std::uint32_t>, case_count> m_hits{};
+    mutable std::atomic<std::uint32_t> m_samples{ 0 };
+};
+
+template<class... Cases>
+FirstOf(Cases&&...) -> FirstOf<std::decay_t<Cases>...>;
+
+namespace detail
+{
+
+template<class T>
+struct is_variant : std::false_type {};
+
+template<class... Ts>
+struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+template<class T>
+inline constexpr bool is_variant_v = is_variant<std::remove_const_t<T>>::value;
+
+// Case of a Switch step : action is executed when the selector returns Key
+template<auto Key, class Action_t>
+struct SwitchCase
+{
+    static constexpr auto key = Key;
+    using shareable = std::bool_constant<detail::shareable_v<Action_t>>;
+
+    Action_t action;
+};
+
+// Default of a Switch step without Default : nothing is executed
+struct NoDefault {};
+
+// Integral value of a key of a Switch step
+template<class T>
+constexpr std::intmax_t switch_key(T value) noexcept
+{
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "The selector of a Switch returns an integral or an enum");
+    if constexpr (std::is_enum_v<T>)
+    {
+        return static_cast<std::intmax_t>(static_cast<std::underlying_type_t<T>>(value));
+    }
+    else
+    {
+        return static_cast<std::intmax_t>(value);
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief A SwitchStep executes the case whose key is returned by the selector, or the Default action when no
+ * case matches (nothing, without Default). It returns the result of the executed action, true if none was.
+ * \code{.cpp}
+ *    ExecutionChain<Message&> router = start_chain
+ *        | Switch([](const Message& m) { return m.type; })
+ *              .Case<Type::Order>(HandleOrder())
+ *              .Case<Type::Cancel>(HandleCancel())
+ *              .Default(Reject());
+ * \endcode
+ * The selector returns an integral or an enum, the keys are values of that type. <br>
+ * When the keys are dense (at least 4 keys, spanning at most twice their count), the case is found in a jump table
+ * indexed by the key. Otherwise the keys are compared in sequence, a comparison the compiler can turn into a switch.
+*/
+template<class Selector_t, class Default_t, class... Cases_t>
+struct SwitchStep : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Selector_t, Default_t, Cases_t...>>;
+
+    template<class SelectorT, class DefaultT, class... CasesT>
+    constexpr SwitchStep(SelectorT&& selector, DefaultT&& default_, CasesT&&... cases)
+        : m_selector(std::forward<SelectorT>(selector))
+        , m_default(std::forward<DefaultT>(default_))
+        , m_cases(std::forward<CasesT>(cases)...)
+    {}
+
+    // Adds the action executed when the selector returns Key
+    template<auto Key, class CaseT>
+    constexpr auto Case(CaseT&& action) &&
+    {
+        static_assert(std::is_same_v<Default_t, detail::NoDefault>, "The cases of a Switch come before its Default");
+        static_assert(((detail::switch_key(Key) != detail::switch_key(Cases_t::key)) && ...), "Duplicate Switch case");
+        using Case_t = detail::SwitchCase<Key, std::decay_t<CaseT>>;
+        return std::apply([&](auto&&... cases)
+        {
+            return SwitchStep<Selector_t, Default_t, Cases_t..., Case_t>(
+                std::move(m_selector), std::move(m_default), std::move(cases)..., Case_t{ std::forward<CaseT>(action) });
+        }, std::move(m_cases));
+    }
+
+    // Sets the action executed when no case matches
+    template<class DefaultT>
+    constexpr auto Default(DefaultT&& action) &&
+    {
+        static_assert(std::is_same_v<Default_t, detail::NoDefault>, "A Switch has a single Default");
+        return std::apply([&](auto&&... cases)
+        {
+            return SwitchStep<Selector_t, std::decay_t<DefaultT>, Cases_t...>(
+                std::move(m_selector), std::forward<DefaultT>(action), std::move(cases)...);
+        }, std::move(m_cases));
+    }
+
+    template<class... Args>
+    static constexpr bool is_invocable = std::is_invocable_v<Selector_t&, Args&...>
+        && (std::is_same_v<Default_t, detail::NoDefault> || std::is_invocable_v<Default_t&, Args&...>)
+        && (std::is_invocable_v<decltype(Cases_t::action)&, Args&...> && ...);
+
+    // the step is immutable when the selector and every action can be called as const
+    template<class... Args>
+    static constexpr bool is_const_invocable = std::is_invocable_v<const Selector_t&, Args&...>
+        && (std::is_same_v<Default_t, detail::NoDefault> || std::is_invocable_v<const Default_t&, Args&...>)
+        && (std::is_invocable_v<const decltype(Cases_t::action)&, Args&...> && ...);
+
+    template<class... Args>
+        requires is_const_invocable<Args...>
+    constexpr bool Execute(Args&... args) const
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires is_invocable<Args...>
+    constexpr bool Execute(Args&... args)
+    {
+        return Run(*this, args...);
+    }
+
+    template<class... Args>
+        requires is_const_invocable<Args...>
+    constexpr bool operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    template<class... Args>
+        requires is_invocable<Args...>
+    constexpr bool operator()(Args&... args)
+    {
+        return Execute(args...);
+    }
+
+private:
+    static constexpr std::array<std::intmax_t, sizeof...(Cases_t)> keys{ detail::switch_key(Cases_t::key)... };
+
+    static constexpr std::intmax_t min_key = sizeof...(Cases_t) ? std::ranges::min(keys) : 0;
+    static constexpr std::intmax_t max_key = sizeof...(Cases_t) ? std::ranges::max(keys) : 0;
+
+    static constexpr bool is_dense = sizeof...(Cases_t) >= 4
+        && static_cast<std::uintmax_t>(max_key - min_key) < 2 * sizeof...(Cases_t);
+
+    template<class Self, class... Args>
+    static constexpr bool RunDefault(Self& self, Args&... args)
+    {
+        if constexpr (std::is_same_v<Default_t, detail::NoDefault>)
+        {
+            return true;
+        }
+        else
+        {
+            return detail::Call(self.m_default, args...);
+        }
+    }
+
+    template<std::size_t I, class Self, class... Args>
+    static constexpr bool RunCase(Self& self, Args&... args)
+    {
+        return detail::Call(std::get<I>(self.m_cases).action, args...);
+    }
+
+    template<class Self, class... Args>
+    static constexpr auto MakeJumpTable()
+    {
+        using Thunk_t = bool (*)(Self&, Args&...);
+        std::array<Thunk_t, static_cast<std::size_t>(max_key - min_key) + 1> table{};
+        table.fill(&RunDefault<Self, Args...>);
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            ((table[static_cast<std::size_t>(keys[I] - min_key)] = &RunCase<I, Self, Args...>), ...);
+        }(std::index_sequence_for<Cases_t...>{});
+        return table;
+    }
+
+    template<class Self, class... Args>
+    static constexpr auto jump_table = MakeJumpTable<Self, Args...>();
+
+    template<class Self, class... Args>
+    static constexpr bool Run(Self& self, Args&... args)
+    {
+        const std::intmax_t key = detail::switch_key(self.m_selector(args...));
+        if constexpr (is_dense)
+        {
+            constexpr const auto& table = jump_table<Self, Args...>;
+            const auto slot = static_cast<std::uintmax_t>(key) - static_cast<std::uintmax_t>(min_key);
+            return slot < table.size() ? table[slot](self, args...) : RunDefault(self, args...);
+        }
+        else
+        {
+            bool result = true;
+            const bool matched = [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return ((key == keys[I] && (result = RunCase<I>(self, args...), true)) || ...);
+            }(std::index_sequence_for<Cases_t...>{});
+            return matched ? result : RunDefault(self, args...);
+        }
+    }
+
+    Selector_t m_selector;
+    [[no_unique_address]] Default_t m_default;
+    std::tuple<Cases_t...> m_cases;
+
+    template<class S, class D, class... C>
+    friend struct SwitchStep;
+};
+
+// Starts a Switch step on the value returned by selector, see SwitchStep
+template<class SelectorT>
+constexpr auto Switch(SelectorT&& selector)
+{
+    return SwitchStep<std::decay_t<SelectorT>, detail::NoDefault>(std::forward<SelectorT>(selector), detail::NoDefault{});
+}
+
+/**
+ * \brief Match dispatches on the alternative held by the first argument, a std::variant. <br>
+ * The alternative is passed to the first action invocable with it (followed by the other arguments),
+ * the alternatives without action are ignored. Match returns the result of the action, true if none was executed.
+ * \code{.cpp}
+ *    ExecutionChain<std::variant<Order, Cancel, Heartbeat>&, Book&> router = start_chain
+ *        | Match([](Order& o, Book& b) { b.Add(o); },
+ *                [](Cancel& c, Book& b) { b.Remove(c.id); }); // Heartbeat is ignored
+ * \endcode
+ * The action is found in a jump table indexed by the index() of the variant.
+*/
+template<class... Actions_t>
+struct Match : ChainStep::LogicFlow
+{
+    // shared by the copies of a chain when its actions are (see is_shareable)
+    using shareable = std::bool_constant<detail::shareable_v<Actions_t...>>;
+
+    // index of the first action invocable with the Alternative, sizeof...(Actions_t) if none
+    template<class Self, class Alternative, class... Args>
+    static constexpr std::size_t action_index = []
+    {
+        constexpr bool invocable[] = {
+            std::is_invocable_v<std::conditional_t<std::is_const_v<Self>, const Actions_t&, Actions_t&>,
+                                Alternative&, Args&...>..., false };
+        std::size_t index = 0;
+        while (index < sizeof...(Actions_t) && !invocable[index])
+        {
+            ++index;
+        }
+        return index;
+    }();
+
+    template<class Variant, class... Args>
+    static constexpr bool is_const_dispatchable = []<std::size_t... I>(std::index_sequence<I...>)
+    {
+        return ((action_index<const Match, std::variant_alternative_t<I, std::remove_const_t<Variant>>, Args...>
+                 == action_index<Match, std::variant_alternative_t<I, std::remove_const_t<Variant>>, Args...>) && ...);
+    }(std::make_index_sequence<std::variant_size_v<std::remove_const_t<Variant>>>{});
+
+    template<class... ActionsT>
+    constexpr explicit Match(ActionsT&&... actions) : m_actions(std::forward<ActionsT>(actions)...) {}
+
+    // the step is immutable when every alternative is dispatched to the same action as const
+    template<class Variant, class... Args>
+        requires detail::is_variant_v<Variant> && is_const_dispatchable<Variant, Args...>
+    constexpr bool Execute(Variant& variant, Args&... args) const
+    {
+        return Run(*this, variant, args...);
+    }
+
+    template<class Variant, class... Args>
+        requires detail::is_variant_v<Variant>
+    constexpr bool Execute(Variant& variant, Args&... args)
+    {
+        return Run(*this, variant, args...);
+    }
+
+    template<class Variant, class... Args>
+        requires detail::is_variant_v<Variant> && is_const_dispatchable<Variant, Args...>
+    constexpr bool operator()(Variant& variant, Args&... args) const
+    {
+        return Execute(variant, args...);
+    }
+
+    template<class Variant, class... Args>
+        requires detail::is_variant_v<Variant>
+    constexpr bool operator()(Variant& variant, Args&... args)
+    {
+        return Execute(variant, args...);
+    }
+
+private:
+    template<std::size_t I, class Self, class Variant, class... Args>
+    static constexpr bool RunAlternative(Self& self, Variant& variant, Args&... args)
+    {
+        auto& alternative = *std::get_if<I>(&variant);
+        constexpr std::size_t index = action_index<Self, std::remove_reference_t<decltype(alternative)>, Args...>;
+        if constexpr (index < sizeof...(Actions_t))
+        {
+            return detail::Call(std::get<index>(self.m_actions), alternative, args...);
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    template<class Self, class Variant, class... Args>
+    static constexpr bool Run(Self& self, Variant& variant, Args&... args)
+    {
+        // a variant valueless by exception holds no alternative
+        return variant.valueless_by_exception() ? true
+                                                : jump_table<Self, Variant, Args...>[variant.index()](self, variant, args...);
+    }
+
+    template<class Self, class Variant, class... Args>
+    static constexpr auto jump_table = []<std::size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<bool (*)(Self&, Variant&, Args&...), sizeof...(I)>{ &RunAlternative<I, Self, Variant, Args...>... };
+    }(std::make_index_sequence<std::variant_size_v<std::remove_const_t<Variant>>>{});
+
+    std::tuple<Actions_t...> m_actions;
+};
+
+template<class... Actions>
+Match(Actions&&...) -> Match<std::decay_t<Actions>...>;
+
+} // namespace chain
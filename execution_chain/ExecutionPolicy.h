@@ -0,0 +1,23 @@
+#pragma once
+
+namespace chain
+{
+
+// The execution policies below select, at compile time, how a chain handles the results of its blocks.
+// Blocks returning void never stop a chain.
+namespace ExecutionPolicy
+{
+    // Every block is executed, whatever the blocks return
+    struct RunToEnd
+    {
+        static constexpr bool short_circuit = false;
+    };
+
+    // The execution stops at the first block returning false
+    struct ShortCircuit
+    {
+        static constexpr bool short_circuit = true;
+    };
+};
+
+} // namespace chain
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace chain
+{
+
+// A set of fields of the context of a chain, one bit per field.
+// The fields are defined by the user, for instance : enum RaceField : FieldMask { Position = 1 << 0, Speed = 1 << 1 };
+using FieldMask = std::uint64_t;
+
+inline constexpr FieldMask NoFields = 0;
+inline constexpr FieldMask AllFields = ~FieldMask{ 0 };
+
+/**
+ * \brief Access<Reads, Writes>(action) declares the fields of the context that an action reads and writes,
+ * for the incremental executions (see ExecutionChain::ExecuteIncremental). <br>
+ * A class can declare them itself instead :
+ * \code{.cpp}
+ *    struct Thrust {
+ *        static constexpr FieldMask reads = Speed | Angle;
+ *        static constexpr FieldMask writes = Position;
+ *        void operator()(Pod&) const;
+ *    };
+ *    auto steer = Access<Target, Angle>([](Pod& pod) { ... });
+ * \endcode
+ * The actions which do not declare their fields are executed at every incremental execution, and may write any
+ * field : the blocks after them see all the fields as dirty. Their writes are not carried to the next execution,
+ * they do not make the blocks before them run again. Declare the fields of an observer, e.g. a logger, with
+ * Access<Fields, NoFields> to skip it when its fields did not change.
+*/
+template<FieldMask Reads, FieldMask Writes, class Action_t>
+struct AccessStep
+{
+    static constexpr FieldMask reads = Reads;
+    static constexpr FieldMask writes = Writes;
+
+    template<class... Args>
+        requires std::is_invocable_v<const Action_t&, Args&...>
+    constexpr decltype(auto) operator()(Args&... args) const
+    {
+        return std::invoke(m_action, args...);
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<Action_t&, Args&...>
+    constexpr decltype(auto) operator()(Args&... args)
+    {
+        return std::invoke(m_action, args...);
+    }
+
+    Action_t m_action;
+};
+
+template<FieldMask Reads, FieldMask Writes, class ActionT>
+constexpr auto Access(ActionT&& action)
+{
+    return AccessStep<Reads, Writes, std::decay_t<ActionT>>{ std::forward<ActionT>(action) };
+}
+
+namespace detail
+{
+
+template<class Action>
+concept declares_fields = requires {
+    { Action::reads } -> std::convertible_to<FieldMask>;
+    { Action::writes } -> std::convertible_to<FieldMask>;
+};
+
+// The fields read by an action, all of them when it does not declare them
+template<class Action>
+constexpr FieldMask fields_read()
+{
+    if constexpr (declares_fields<Action>) {
+        return Action::reads;
+    }
+    else {
+        return AllFields;
+    }
+}
+
+// The fields written by an action, all of them when it does not declare them
+template<class Action>
+constexpr FieldMask fields_written()
+{
+    if constexpr (declares_fields<Action>) {
+        return Action::writes;
+    }
+    else {
+        return AllFields;
+    }
+}
+
+// Dirty fields of an incremental execution
+struct DirtyFields
+{
+    // Runs execute() if the action reads a dirty field, and marks the fields it writes as dirty.
+    // The fields written for an action which already ran (including itself) stay dirty for the next execution.
+    // Returns the result of execute, true for a skipped action.
+    template<class F>
+    constexpr bool run(FieldMask reads, FieldMask writes, F&& execute)
+    {
+        read |= reads;
+        if (!(reads & dirty)) {
+            return true;
+        }
+        const bool result = std::forward<F>(execute)();
+        dirty |= writes;
+        pending |= writes & read;
+        return result;
+    }
+
+    // Runs the action of a block which does not declare its fields, whatever the dirty fields (see Access)
+    template<class F>
+    constexpr bool run_undeclared(F&& execute)
+    {
+        const bool result = std::forward<F>(execute)();
+        dirty = AllFields;
+        return result;
+    }
+
+    // Runs execute() as an action declaring its fields or as an undeclared one, depending on Action
+    template<class Action, class F>
+    constexpr bool run_action(F&& execute)
+    {
+        if constexpr (declares_fields<Action>) {
+            return run(Action::reads, Action::writes, std::forward<F>(execute));
+        }
+        else {
+            return run_undeclared(std::forward<F>(execute));
+        }
+    }
+
+    FieldMask dirty;
+    FieldMask read = NoFields;
+    FieldMask pending = NoFields;
+};
+
+} // namespace detail
+
+} // namespace chain
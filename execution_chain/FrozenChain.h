@@ -0,0 +1,264 @@
+#pragma once
+
+#include "BlockArena.h"
+#include "ExecutionPolicy.h"
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+template <class Policy, class... Args>
+class BasicExecutionChain;
+
+template <class Policy, class... Args>
+class BasicFrozenChain;
+
+template <class... Args>
+using FrozenChain = BasicFrozenChain<ExecutionPolicy::RunToEnd, Args...>;
+
+/**
+ * \brief A FrozenChain is an immutable snapshot of an ExecutionChain, obtained with ExecutionChain::freeze().
+ * \code{.cpp}
+ *    ExecutionChain<int> chain = start_chain | [](int& a) { ++a; } | [](int& a) { a*=4; };
+ *    const FrozenChain<int> frozen = chain.freeze();
+ *    int x = 0;
+ *    frozen(x); // --> x = 4
+ * \endcode
+ *
+ * \details The FrozenChain stores all of its blocks and its program in one single allocation : a flat array of
+ * instructions `{ void(*)(void*, Args&...), void* }`, followed by the blocks themselves. <br>
+ * Executing the FrozenChain walks the instructions in order and calls each thunk on its block,
+ * there is no virtual call and no offset computation in the loop. <br>
+ * A BlockTuple appended to an ExecutionChain is stored as a single block : its actions are
+ * executed by a single instruction, keeping the compile-time fold of BlockTuple::Execute. <br>
+ * A FrozenChain can be copied and moved, but no action can be added to it. <br>
+ * The frozen chain keeps the execution policy of the chain it was obtained from.
+*/
+template <class Policy, class... Args>
+class BasicFrozenChain
+{
+    struct Instruction {
+        bool (*execute)(void*, Args&...);
+        void* block;
+    };
+
+    static constexpr std::size_t header_align = std::max(alignof(Instruction), alignof(const detail::BlockLifetime*));
+
+public:
+    BasicFrozenChain() = default;
+
+    BasicFrozenChain(const BasicFrozenChain& other)
+    {
+        build(other.m_count, other.m_align, other.m_bytes,
+              [&](std::size_t i) { return other.instructions()[i].execute; },
+              [&](std::size_t i) { return other.lifetimes()[i]; },
+              [&](std::size_t i) { return static_cast<const std::byte*>(other.instructions()[i].block); },
+              [&](std::size_t i) { return other.offset(i); });
+    }
+
+    BasicFrozenChain(BasicFrozenChain&& other) noexcept
+        : m_storage(std::exchange(other.m_storage, nullptr))
+        , m_count(std::exchange(other.m_count, 0))
+        , m_bytes(std::exchange(other.m_bytes, 0))
+        , m_align(std::exchange(other.m_align, header_align))
+    {
+    }
+
+    BasicFrozenChain& operator=(const BasicFrozenChain& other)
+    {
+        if (this != &other) {
+            BasicFrozenChain copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    BasicFrozenChain& operator=(BasicFrozenChain&& other) noexcept
+    {
+        if (this != &other) {
+            BasicFrozenChain moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    ~BasicFrozenChain()
+    {
+        release();
+    }
+
+    void swap(BasicFrozenChain& other) noexcept
+    {
+        std::swap(m_storage, other.m_storage);
+        std::swap(m_count, other.m_count);
+        std::swap(m_bytes, other.m_bytes);
+        std::swap(m_align, other.m_align);
+    }
+
+    template<class... ExecArgsT>
+    struct acceptable_args : std::conjunction<std::is_convertible<ExecArgsT, Args>...> {};
+
+    template<class... ExecArgsT>
+    using enable_if_all_args_are_compatible = std::enable_if_t<acceptable_args<ExecArgsT...>::value, bool>;
+
+    // Executes the blocks in order, returns true if the chain ran to the end
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool Execute(ExecArgsT&&... args) const {
+        const Instruction* const end = instructions() + m_count;
+        for (const Instruction* instruction = instructions(); instruction != end; ++instruction) {
+            if constexpr (Policy::short_circuit) {
+                if (!instruction->execute(instruction->block, args...)) {
+                    return false;
+                }
+            }
+            else {
+                instruction->execute(instruction->block, args...);
+            }
+        }
+        return true;
+    }
+
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool operator()(ExecArgsT&&... args) const {
+        return Execute(args...);
+    }
+
+    // number of blocks of the chain
+    std::size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_count == 0;
+    }
+
+private:
+    template <class P, class... A>
+    friend class BasicExecutionChain;
+
+    // Copies the blocks of the segments of a chain, the arenas of the segments are laid out one after the other
+    template <class SegmentsT>
+    explicit BasicFrozenChain(const SegmentsT& segments)
+    {
+        struct Source {
+            bool (*execute)(void*, Args&...);
+            const detail::BlockLifetime* lifetime;
+            const std::byte* block;
+            std::size_t offset;
+        };
+
+        std::vector<Source> sources;
+        std::size_t align = 1;
+        std::size_t bytes = 0;
+        for (const auto& segment : segments) {
+            const auto& arena = segment->arena;
+            const std::size_t base = detail::align_up(bytes, arena.alignment());
+            for (std::size_t i = 0; i < arena.count(); ++i) {
+                sources.push_back({ segment->dispatch[i].execute, &arena.lifetime(i),
+                                    arena.data() + arena.offset(i), base + arena.offset(i) });
+            }
+            bytes = base + arena.size();
+            align = std::max(align, arena.alignment());
+        }
+
+        build(sources.size(), align, bytes,
+              [&](std::size_t i) { return sources[i].execute; },
+              [&](std::size_t i) { return sources[i].lifetime; },
+              [&](std::size_t i) { return sources[i].block; },
+              [&](std::size_t i) { return sources[i].offset; });
+    }
+
+    // Storage layout : [Instruction x count][const BlockLifetime* x count][padding][blocks]
+    static std::size_t blocks_offset(std::size_t count, std::size_t align) noexcept
+    {
+        return detail::align_up(count * (sizeof(Instruction) + sizeof(const detail::BlockLifetime*)), align);
+    }
+
+    // The i-th block is copied from source_of(i) at offset_of(i) in the blocks area
+    template <class ExecuteF, class LifetimeF, class SourceF, class OffsetF>
+    void build(std::size_t count, std::size_t align, std::size_t bytes,
+               ExecuteF&& execute_of, LifetimeF&& lifetime_of, SourceF&& source_of, OffsetF&& offset_of)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        align = std::max(align, header_align);
+        auto* storage = static_cast<std::byte*>(::operator new(blocks_offset(count, align) + bytes,
+                                                               std::align_val_t{ align }));
+        auto* instructions = reinterpret_cast<Instruction*>(storage);
+        auto* lifetimes = reinterpret_cast<const detail::BlockLifetime**>(storage + count * sizeof(Instruction));
+        std::byte* blocks = storage + blocks_offset(count, align);
+
+        std::size_t copied = 0;
+        try {
+            for (; copied < count; ++copied) {
+                const detail::BlockLifetime* lifetime = lifetime_of(copied);
+                const std::size_t offset = offset_of(copied);
+                lifetime->copy(source_of(copied), blocks + offset);
+                ::new (&instructions[copied]) Instruction{ execute_of(copied), blocks + offset };
+                lifetimes[copied] = lifetime;
+            }
+        }
+        catch (...) {
+            for (std::size_t i = copied; i > 0; --i) {
+                lifetimes[i - 1]->destroy(instructions[i - 1].block);
+            }
+            ::operator delete(storage, std::align_val_t{ align });
+            throw;
+        }
+
+        m_storage = storage;
+        m_count = count;
+        m_bytes = bytes;
+        m_align = align;
+    }
+
+    void release() noexcept
+    {
+        if (!m_storage) {
+            return;
+        }
+
+        for (std::size_t i = m_count; i > 0; --i) {
+            lifetimes()[i - 1]->destroy(instructions()[i - 1].block);
+        }
+        ::operator delete(m_storage, std::align_val_t{ m_align });
+        m_storage = nullptr;
+        m_count = 0;
+    }
+
+    const Instruction* instructions() const noexcept
+    {
+        return reinterpret_cast<const Instruction*>(m_storage);
+    }
+
+    const detail::BlockLifetime* const* lifetimes() const noexcept
+    {
+        return reinterpret_cast<const detail::BlockLifetime* const*>(m_storage + m_count * sizeof(Instruction));
+    }
+
+    std::byte* blocks() const noexcept
+    {
+        return m_storage + blocks_offset(m_count, m_align);
+    }
+
+    std::size_t offset(std::size_t index) const noexcept
+    {
+        return static_cast<std::size_t>(static_cast<std::byte*>(instructions()[index].block) - blocks());
+    }
+
+    std::byte* m_storage = nullptr;
+    std::size_t m_count = 0;
+    std::size_t m_bytes = 0;
+    std::size_t m_align = header_align;
+};
+
+} // namespace chain
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "ExecutionChain.h"
+#include "FieldAccess.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+template <class Policy, class... Args>
+class BasicGraphChain;
+
+template <class... Args>
+using GraphChain = BasicGraphChain<ExecutionPolicy::RunToEnd, Args...>;
+
+template <class... Args>
+using ShortCircuitGraphChain = BasicGraphChain<ExecutionPolicy::ShortCircuit, Args...>;
+
+/**
+ * \brief A GraphChain executes blocks ordered by their dependencies only : the blocks which do not depend on each
+ * other run at the same time on a ThreadPool. <br>
+ * A block either lists the blocks it depends on, or declares the fields of the context it reads and writes
+ * (see Access) : it then depends on the blocks added before it which write a field it reads or writes, or read
+ * a field it writes.
+ * \code{.cpp}
+ *    GraphChain<Race&> graph(pool);
+ *    const auto mine = graph.Add(Access<Pods, MyCollisions>(FindMyCollisions()));
+ *    const auto other = graph.Add(Access<Pods, OtherCollisions>(FindOtherCollisions())); // runs with `mine`
+ *    graph.Add(Thrust(), { mine, other });
+ *    graph.Execute(race);
+ * \endcode
+ *
+ * \details A block can only depend on the blocks added before it : the graph is acyclic by construction. <br>
+ * The schedule is a sequence of levels, updated by Add : a block is in the level following the last level of its
+ * dependencies. The blocks of a level run in parallel, and a level starts once the previous one is done : the
+ * latency of an execution is the one of the longest path of the graph (CriticalPath). <br>
+ * The blocks which do not declare their fields read and write all of them : added without dependencies, they
+ * keep the order of an ExecutionChain. <br>
+ * With the ShortCircuit policy, the execution stops after the level of the first block returning false. <br>
+ * The blocks of a level share the arguments : they must modify independent data.
+*/
+template <class Policy, class... Args>
+class BasicGraphChain
+{
+public:
+    using NodeId = std::size_t;
+
+    BasicGraphChain() = default;
+
+    explicit BasicGraphChain(ThreadPool& pool) : m_pool(&pool) {}
+
+    // Adds a block depending on the blocks added before it which access the same fields
+    template<class ActionT>
+    NodeId Add(ActionT&& action)
+    {
+        using Action_t = std::decay_t<ActionT>;
+        constexpr FieldMask reads = detail::fields_read<Action_t>();
+        constexpr FieldMask writes = detail::fields_written<Action_t>();
+
+        std::vector<NodeId> dependencies;
+        for (NodeId id = 0; id < m_nodes.size(); ++id) {
+            const Node& node = m_nodes[id];
+            if ((node.writes & (reads | writes)) || (node.reads & writes)) {
+                dependencies.push_back(id);
+            }
+        }
+        return Insert(std::forward<ActionT>(action), std::move(dependencies), reads, writes);
+    }
+
+    // Adds a block depending on the given blocks only
+    template<class ActionT>
+    NodeId Add(ActionT&& action, std::initializer_list<NodeId> dependencies)
+    {
+        using Action_t = std::decay_t<ActionT>;
+        return Insert(std::forward<ActionT>(action), std::vector<NodeId>(dependencies),
+                      detail::fields_read<Action_t>(), detail::fields_written<Action_t>());
+    }
+
+    // Executes the levels in order, the blocks of a level in parallel. Returns true if the graph ran to the end.
+    template<class... ExecArgsT>
+    bool Execute(ExecArgsT&&... args) const
+    {
+        ThreadPool& pool = m_pool ? *m_pool : ThreadPool::Default();
+        for (const std::vector<NodeId>& level : m_levels) {
+            std::atomic<bool> succeeded{ true };
+            const auto run = [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    if (!m_nodes[level[i]].chain.Execute(args...)) {
+                        succeeded.store(false, std::memory_order_relaxed);
+                    }
+                }
+            };
+            if (level.size() == 1) {
+                run(0, 1);
+            }
+            else {
+                pool.ParallelFor(level.size(), 1, run);
+            }
+
+            if (Policy::short_circuit && !succeeded.load(std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class... ExecArgsT>
+    bool operator()(ExecArgsT&&... args) const
+    {
+        return Execute(std::forward<ExecArgsT>(args)...);
+    }
+
+    // The blocks each block depends on
+    const std::vector<NodeId>& Dependencies(NodeId id) const
+    {
+        return m_nodes[id].dependencies;
+    }
+
+    // The schedule : the blocks of a level only depend on the blocks of the previous levels
+    const std::vector<std::vector<NodeId>>& Levels() const noexcept
+    {
+        return m_levels;
+    }
+
+    // Number of levels, the blocks on the longest path of the graph
+    std::size_t CriticalPath() const noexcept
+    {
+        return m_levels.size();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_nodes.size();
+    }
+
+private:
+    struct Node
+    {
+        // a single block, returning the result of the action
+        BasicExecutionChain<ExecutionPolicy::ShortCircuit, Args...> chain;
+        std::vector<NodeId> dependencies;
+        FieldMask reads;
+        FieldMask writes;
+        std::size_t level;
+    };
+
+    template<class ActionT>
+    NodeId Insert(ActionT&& action, std::vector<NodeId> dependencies, FieldMask reads, FieldMask writes)
+    {
+        std::size_t level = 0;
+        for (const NodeId dependency : dependencies) {
+            assert(dependency < m_nodes.size() && "GraphChain : a block can only depend on the blocks added before it");
+            level = std::max(level, m_nodes[dependency].level + 1);
+        }
+
+        Node node{ {}, std::move(dependencies), reads, writes, level };
+        node.chain |= std::forward<ActionT>(action);
+
+        const NodeId id = m_nodes.size();
+        m_nodes.push_back(std::move(node));
+        try {
+            if (level == m_levels.size()) {
+                m_levels.emplace_back();
+            }
+            m_levels[level].push_back(id);
+        }
+        catch (...) {
+            m_nodes.pop_back();
+            throw;
+        }
+        return id;
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<std::vector<NodeId>> m_levels;
+    ThreadPool* m_pool = nullptr;
+};
+
+} // namespace chain
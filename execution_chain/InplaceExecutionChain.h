@@ -0,0 +1,190 @@
+#pragma once
+
+#include "BlockTuple.h"
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace chain
+{
+
+template <class Policy, std::size_t MaxBlocks, std::size_t MaxBytes, class... Args>
+class BasicInplaceExecutionChain;
+
+// Executes every block of the chain
+template <std::size_t MaxBlocks, std::size_t MaxBytes, class... Args>
+using InplaceExecutionChain = BasicInplaceExecutionChain<ExecutionPolicy::RunToEnd, MaxBlocks, MaxBytes, Args...>;
+
+// Stops the execution at the first block returning false
+template <std::size_t MaxBlocks, std::size_t MaxBytes, class... Args>
+using InplaceShortCircuitChain = BasicInplaceExecutionChain<ExecutionPolicy::ShortCircuit, MaxBlocks, MaxBytes, Args...>;
+
+/**
+ * \brief An InplaceExecutionChain is an ExecutionChain of fixed capacity : at most MaxBlocks actions,
+ * stored in an inline buffer of MaxBytes bytes.
+ * \code{.cpp}
+ *    InplaceExecutionChain<4, 64, int> chain = start_chain | [](int& a) { ++a; };
+ *    chain |= [](int& a) { a*=4; };
+ *    int x = 0;
+ *    chain(x); // --> x = 4
+ * \endcode
+ *
+ * \details The chain never allocates, does not rely on RTTI and does not throw. <br>
+ * The actions must be trivially copy constructible and trivially destructible (e.g. lambdas capturing
+ * pointers or plain values) : the chain itself is then trivially copyable, it can be copied with memcpy. <br>
+ * The blocks are dispatched through function pointers : a chain (or its copy) can only be executed in the address
+ * space of the process which built it, e.g. by its threads or by its forked children. Another process mapping a
+ * shared memory holding the chain must not execute it, its code is loaded at other addresses. <br>
+ * An action which can never fit (too large, or over-aligned) is rejected at compile time. <br>
+ * When the remaining capacity is too small, try_append returns false and leaves the chain unchanged,
+ * operator|= asserts. <br>
+ * A BlockTuple is stored as a single block, like in an ExecutionChain. As for the ExecutionChain, the Policy
+ * tells whether the chain stops at the first block returning false (see InplaceShortCircuitChain).
+*/
+template <class Policy, std::size_t MaxBlocks, std::size_t MaxBytes, class... Args>
+class BasicInplaceExecutionChain
+{
+    static_assert(MaxBlocks > 0 && MaxBytes > 0, "An InplaceExecutionChain must be able to store an action");
+
+    static constexpr std::size_t storage_align = alignof(std::max_align_t);
+
+    struct Entry {
+        bool (*execute)(void*, Args&...);
+        std::size_t offset;
+    };
+
+    // Returns the result of the action if it returns a bool, true otherwise
+    template <class Action>
+    static bool ExecuteBlock(void* pBlock, Args&... args) {
+        auto& action = *static_cast<Action*>(pBlock);
+        if constexpr (is_block_tuple_v<Action>) {
+            return action.template Execute<Policy>(args...);
+        }
+        else {
+            return detail::Call(action, args...);
+        }
+    }
+
+public:
+    template <class ActionT>
+    struct is_storable : std::bool_constant<
+        !std::is_same_v<std::decay_t<ActionT>, BasicInplaceExecutionChain>
+        && std::is_trivially_copy_constructible_v<std::decay_t<ActionT>>
+        && std::is_trivially_destructible_v<std::decay_t<ActionT>>
+        && std::is_invocable_v<std::decay_t<ActionT>&, Args&...>> {};
+
+    template <class ActionT>
+    using enable_if_storable = std::enable_if_t<is_storable<ActionT>::value, bool>;
+
+    BasicInplaceExecutionChain() = default;
+
+    template <class ActionT, enable_if_storable<ActionT> = true>
+    BasicInplaceExecutionChain(ActionT&& action)
+    {
+        *this |= std::forward<ActionT>(action);
+    }
+
+    // Clears the chain and appends an action
+    template <class ActionT, enable_if_storable<ActionT> = true>
+    BasicInplaceExecutionChain& operator=(ActionT&& action)
+    {
+        clear();
+        return *this |= std::forward<ActionT>(action);
+    }
+
+    // Appends an action to the chain, the action must fit in the remaining capacity
+    template <class ActionT, enable_if_storable<ActionT> = true>
+    BasicInplaceExecutionChain& operator|=(ActionT&& action)
+    {
+        [[maybe_unused]] const bool appended = try_append(std::forward<ActionT>(action));
+        assert(appended && "InplaceExecutionChain : the action does not fit in the remaining capacity");
+        return *this;
+    }
+
+    // Appends an action to the chain if it fits in the remaining capacity, returns false otherwise
+    template <class ActionT, enable_if_storable<ActionT> = true>
+    bool try_append(ActionT&& action) noexcept(std::is_nothrow_constructible_v<std::decay_t<ActionT>, ActionT&&>)
+    {
+        using Action_t = std::decay_t<ActionT>;
+        static_assert(sizeof(Action_t) <= MaxBytes, "The action is larger than the capacity of the chain");
+        static_assert(alignof(Action_t) <= storage_align, "The alignment of the action is not supported");
+
+        const std::size_t offset = (m_size + alignof(Action_t) - 1) / alignof(Action_t) * alignof(Action_t);
+        if (m_count == MaxBlocks || offset + sizeof(Action_t) > MaxBytes) {
+            return false;
+        }
+
+        ::new (m_storage + offset) Action_t(std::forward<ActionT>(action));
+        m_entries[m_count++] = { &ExecuteBlock<Action_t>, offset };
+        m_size = offset + sizeof(Action_t);
+        return true;
+    }
+
+    template<class... ExecArgsT>
+    struct acceptable_args : std::conjunction<std::is_convertible<ExecArgsT, Args>...> {};
+
+    template<class... ExecArgsT>
+    using enable_if_all_args_are_compatible = std::enable_if_t<acceptable_args<ExecArgsT...>::value, bool>;
+
+    // Executes the blocks in order, returns true if the execution ran to the end
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool Execute(ExecArgsT&&... args) const {
+        for (std::size_t i = 0; i < m_count; ++i) {
+            const bool succeeded = m_entries[i].execute(m_storage + m_entries[i].offset, args...);
+            if (!succeeded && Policy::short_circuit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class... ExecArgsT, enable_if_all_args_are_compatible<ExecArgsT...> = true>
+    bool operator()(ExecArgsT&&... args) const {
+        return Execute(args...);
+    }
+
+    // the actions are trivially destructible : clearing only resets the counters
+    void clear() noexcept
+    {
+        m_count = 0;
+        m_size = 0;
+    }
+
+    // number of blocks of the chain
+    std::size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_count == 0;
+    }
+
+    // number of bytes used by the actions (padding included)
+    std::size_t bytes() const noexcept
+    {
+        return m_size;
+    }
+
+    static constexpr std::size_t max_blocks() noexcept
+    {
+        return MaxBlocks;
+    }
+
+    static constexpr std::size_t max_bytes() noexcept
+    {
+        return MaxBytes;
+    }
+
+private:
+    Entry m_entries[MaxBlocks] = {};
+    std::size_t m_count = 0;
+    std::size_t m_size = 0;
+    // the actions are executed from a const chain, like the blocks of an ExecutionChain
+    alignas(storage_align) mutable std::byte m_storage[MaxBytes];
+};
+
+} // namespace chain
@@ -0,0 +1,269 @@
+#pragma once
+
+// Define EXECUTION_CHAIN_INSTRUMENTATION to 1 (for the whole program) to record execution statistics for
+// each block of the chains. When it is not defined, nothing is recorded and the chains are left unchanged.
+// The statistics are queried with ExecutionChain::Report and BlockTuple::Report. They are held by the blocks
+// themselves, which makes a BlockTuple not trivially copyable (and not storable in an InplaceExecutionChain)
+// when the instrumentation is enabled. The latencies are measured with std::chrono::steady_clock.
+#ifndef EXECUTION_CHAIN_INSTRUMENTATION
+#define EXECUTION_CHAIN_INSTRUMENTATION 0
+#endif
+
+#if EXECUTION_CHAIN_INSTRUMENTATION
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+// How often each branch of a logic flow step was taken
+struct BranchReport
+{
+    // If : the Then branch was executed. Try : the Try action succeeded.
+    std::uint64_t primary = 0;
+    // If : the Else branch was executed, or the predicate failed. Try : the Fallback was executed.
+    std::uint64_t alternative = 0;
+};
+
+/**
+ * \brief Execution statistics of a block of a chain (see ExecutionChain::Report). <br>
+ * The latencies are recorded in a histogram whose bucket i holds the executions which lasted
+ * less than 2^(i+1) nanoseconds (and at least 2^i, for i > 0).
+*/
+struct BlockReport
+{
+    static constexpr std::size_t bucket_count = 40;
+
+    // position of the block in the chain (or of the action in its BlockTuple)
+    std::size_t index = 0;
+    // type of the action
+    const std::type_info* type = &typeid(void);
+
+    std::uint64_t calls = 0;
+    std::chrono::nanoseconds total{ 0 };
+    std::array<std::uint64_t, bucket_count> histogram{};
+
+    // for the IfThen, IfThenElse and TryFallback steps
+    std::optional<BranchReport> branches;
+    // for a BlockTuple stored as a block : the statistics of each of its actions
+    std::vector<BlockReport> actions;
+
+    std::chrono::nanoseconds Mean() const noexcept
+    {
+        return calls ? total / static_cast<std::int64_t>(calls) : std::chrono::nanoseconds{ 0 };
+    }
+
+    // Upper bound of the latency of the fraction q (in [0, 1]) of the fastest executions, e.g. Percentile(0.99)
+    std::chrono::nanoseconds Percentile(double q) const noexcept
+    {
+        const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(calls));
+        std::uint64_t count = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            count += histogram[i];
+            if (count != 0 && count >= rank)
+            {
+                return std::chrono::nanoseconds{ std::int64_t{ 2 } << i };
+            }
+        }
+        return std::chrono::nanoseconds{ 0 };
+    }
+};
+
+// Execution statistics of the blocks of a chain, in the order of the chain
+struct ChainReport
+{
+    std::vector<BlockReport> blocks;
+
+    // the block with the largest cumulative latency, nullptr if the chain is empty
+    const BlockReport* Slowest() const noexcept
+    {
+        const BlockReport* slowest = nullptr;
+        for (const auto& block : blocks)
+        {
+            if (!slowest || block.total > slowest->total)
+            {
+                slowest = &block;
+            }
+        }
+        return slowest;
+    }
+};
+
+namespace detail
+{
+
+// Relaxed atomic counter which can be copied, so that the blocks holding it can be copied
+class RelaxedCounter
+{
+public:
+    RelaxedCounter() noexcept = default;
+    RelaxedCounter(const RelaxedCounter& other) noexcept : m_value(other.load()) {}
+
+    RelaxedCounter& operator=(const RelaxedCounter& other) noexcept
+    {
+        m_value.store(other.load(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void add(std::uint64_t value) noexcept
+    {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::uint64_t load() const noexcept
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        m_value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> m_value{ 0 };
+};
+
+// Calls and latencies of a block. The blocks shared by several chains (or executed concurrently)
+// share their statistics.
+class BlockProfile
+{
+public:
+    using Clock_t = std::chrono::steady_clock;
+
+    // Calls fn and records its latency
+    template <class F>
+    decltype(auto) measure(F&& fn)
+    {
+        struct Record
+        {
+            ~Record() { profile.record(Clock_t::now() - start); }
+            BlockProfile& profile;
+            Clock_t::time_point start;
+        } record{ *this, Clock_t::now() };
+        return std::forward<F>(fn)();
+    }
+
+    void record(Clock_t::duration duration) noexcept
+    {
+        const auto nanoseconds = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        const std::size_t bucket = nanoseconds < 2 ? 0 : std::bit_width(nanoseconds) - 1;
+        m_calls.add(1);
+        m_total.add(nanoseconds);
+        m_histogram[bucket < BlockReport::bucket_count ? bucket : BlockReport::bucket_count - 1].add(1);
+    }
+
+    BlockReport report(std::size_t index, const std::type_info& type) const
+    {
+        BlockReport report;
+        report.index = index;
+        report.type = &type;
+        report.calls = m_calls.load();
+        report.total = std::chrono::nanoseconds(m_total.load());
+        for (std::size_t i = 0; i < BlockReport::bucket_count; ++i)
+        {
+            report.histogram[i] = m_histogram[i].load();
+        }
+        return report;
+    }
+
+    void reset() noexcept
+    {
+        m_calls.reset();
+        m_total.reset();
+        for (auto& bucket : m_histogram)
+        {
+            bucket.reset();
+        }
+    }
+
+private:
+    RelaxedCounter m_calls;
+    RelaxedCounter m_total;
+    std::array<RelaxedCounter, BlockReport::bucket_count> m_histogram;
+};
+
+// How often each branch of a logic flow step was taken (see BranchReport)
+struct BranchProfile
+{
+    void take_primary() noexcept
+    {
+        primary.add(1);
+    }
+
+    void take_alternative() noexcept
+    {
+        alternative.add(1);
+    }
+
+    BranchReport report() const noexcept
+    {
+        return { primary.load(), alternative.load() };
+    }
+
+    void reset() noexcept
+    {
+        primary.reset();
+        alternative.reset();
+    }
+
+    RelaxedCounter primary;
+    RelaxedCounter alternative;
+};
+
+// Report of the block holding action, with the statistics of its branches or of its actions if it has any
+template <class Action>
+BlockReport make_block_report(std::size_t index, const Action& action, const BlockProfile& profile)
+{
+    BlockReport report = profile.report(index, typeid(Action));
+    if constexpr (requires { action.Branches(); })
+    {
+        report.branches = action.Branches();
+    }
+    if constexpr (requires { action.Report(); })
+    {
+        report.actions = action.Report().blocks;
+    }
+    return report;
+}
+
+template <class Action>
+void reset_block_report(Action& action, BlockProfile& profile) noexcept
+{
+    profile.reset();
+    if constexpr (requires { action.ResetReport(); })
+    {
+        action.ResetReport();
+    }
+}
+
+} // namespace detail
+
+} // namespace chain
+
+#else
+
+namespace chain::detail
+{
+
+// Nothing is recorded when the instrumentation is disabled
+struct BranchProfile
+{
+    constexpr void take_primary() const noexcept {}
+    constexpr void take_alternative() const noexcept {}
+};
+
+} // namespace chain::detail
+
+#endif // EXECUTION_CHAIN_INSTRUMENTATION
@@ -0,0 +1,391 @@
+#pragma once
+
+#include "ExecutionChain.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+enum class CachePolicy
+{
+    // one entry per slot, a key replaces the entry of its slot (the slot is picked by the hash of the key)
+    DirectMapped,
+    // the least recently used entry is evicted when the cache is full
+    LeastRecentlyUsed,
+};
+
+struct MemoizeOptions
+{
+    // maximum number of results kept by a cache
+    std::size_t capacity = 64;
+
+    CachePolicy policy = CachePolicy::DirectMapped;
+
+    // each thread has its own cache, instead of a single cache shared under a lock
+    bool threadLocal = false;
+};
+
+namespace detail
+{
+
+// Bounded cache of the results of a Memoize step, not thread-safe
+template<class Key, class Result>
+class MemoCache
+{
+public:
+    MemoCache(std::size_t capacity, CachePolicy policy) : m_capacity(capacity), m_policy(policy)
+    {
+        assert(capacity > 0 && "Memoize : the capacity must not be 0");
+        if (policy == CachePolicy::DirectMapped)
+        {
+            m_slots.resize(capacity);
+        }
+        else
+        {
+            m_index.reserve(capacity);
+        }
+    }
+
+    const Result* find(const Key& key)
+    {
+        if (m_policy == CachePolicy::DirectMapped)
+        {
+            auto& slot = m_slots[std::hash<Key>{}(key) % m_capacity];
+            return slot && slot->first == key ? &slot->second : nullptr;
+        }
+
+        const auto found = m_index.find(key);
+        if (found == m_index.end())
+        {
+            return nullptr;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return &found->second->second;
+    }
+
+    void insert(const Key& key, Result result)
+    {
+        if (m_policy == CachePolicy::DirectMapped)
+        {
+            m_slots[std::hash<Key>{}(key) % m_capacity].emplace(key, std::move(result));
+            return;
+        }
+
+        if (const auto found = m_index.find(key); found != m_index.end())
+        {
+            // inserted by another execution in the meantime
+            found->second->second = std::move(result);
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            return;
+        }
+        if (m_entries.size() == m_capacity)
+        {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+        m_entries.emplace_front(key, std::move(result));
+        m_index.emplace(key, m_entries.begin());
+    }
+
+    void clear()
+    {
+        m_slots.assign(m_slots.size(), std::nullopt);
+        m_entries.clear();
+        m_index.clear();
+    }
+
+private:
+    using Entry_t = std::pair<Key, Result>;
+
+    std::size_t m_capacity;
+    CachePolicy m_policy;
+
+    // DirectMapped
+    std::vector<std::optional<Entry_t>> m_slots;
+
+    // LeastRecentlyUsed : most recent first
+    std::list<Entry_t> m_entries;
+    std::unordered_map<Key, typename std::list<Entry_t>::iterator> m_index;
+};
+
+} // namespace detail
+
+/**
+ * \brief Memoize caches the result of a pure computation by a key derived from the arguments : the computation
+ * is skipped when the key repeats. <br>
+ * Memoize(key, compute) returns the (possibly cached) result of compute(args...), it can for instance be the
+ * predicate of an If. Memoize(key, compute, apply) calls apply(result, args...) with the result on every execution,
+ * and returns the result of apply : the expensive part is cached, its effect on the arguments is not.
+ * \code{.cpp}
+ *    ExecutionChain<Race&> chain = start_chain
+ *        | Memoize([](const Race& r) { return r.PodsConfiguration(); },  // key
+ *                  [](const Race& r) { return FindCollisions(r); },      // skipped when the pods did not move
+ *                  [](const Collisions& c, Race& r) { r.Apply(c); },
+ *                  MemoizeOptions{ .capacity = 16, .policy = CachePolicy::LeastRecentlyUsed })
+ *        | Thrust();
+ * \endcode
+ * The key must be hashable (std::hash) and equality comparable, the result copyable. A step executed with arguments
+ * of other types giving other key or result types, e.g. a generic key called with `Race&` and with `const Race&`,
+ * keeps a separate cache for each of these types. <br>
+ * By default the cache is shared by the threads executing the step, under a lock (compute runs outside of it).
+ * With threadLocal, each thread has its own cache, created on demand without lock. The cache of a thread which
+ * exited is reused by a later thread (see detail::thread_index). When more than 4096 threads are alive at the same
+ * time, the threads beyond use the shared cache. Copies of the step start with empty caches : the step is never shared
+ * by the copies of an ExecutionChain (see is_shareable), each copy of the chain fills its own caches. <br>
+ * The key, compute and apply are called as const.
+*/
+template<class Key_t, class Compute_t, class Apply_t>
+struct MemoizeStep : ChainStep::LogicFlow
+{
+    // the caches are a state of each copy
+    using shareable = std::false_type;
+
+    template<class KeyT, class ComputeT, class ApplyT>
+    MemoizeStep(KeyT&& key, ComputeT&& compute, ApplyT&& apply, MemoizeOptions options)
+        : m_key(std::forward<KeyT>(key))
+        , m_compute(std::forward<ComputeT>(compute))
+        , m_apply(std::forward<ApplyT>(apply))
+        , m_options(options)
+        , m_threadCaches(options.threadLocal ? std::make_unique<ThreadCaches>() : nullptr)
+    {}
+
+    MemoizeStep(const MemoizeStep& other)
+        : m_key(other.m_key)
+        , m_compute(other.m_compute)
+        , m_apply(other.m_apply)
+        , m_options(other.m_options)
+        , m_threadCaches(other.m_threadCaches ? std::make_unique<ThreadCaches>() : nullptr)
+    {}
+
+    MemoizeStep(MemoizeStep&& other)
+        : m_key(std::move(other.m_key))
+        , m_compute(std::move(other.m_compute))
+        , m_apply(std::move(other.m_apply))
+        , m_options(other.m_options)
+        , m_threadCaches(other.m_threadCaches ? std::make_unique<ThreadCaches>() : nullptr)
+    {}
+
+    MemoizeStep& operator=(const MemoizeStep&) = delete;
+
+    // the key and the computation are pure, they are always called as const
+    template<class... Args>
+        requires std::is_invocable_v<const Key_t&, Args&...> && std::is_invocable_v<const Compute_t&, Args&...>
+    decltype(auto) Execute(Args&... args) const
+    {
+        using Result_t = std::decay_t<std::invoke_result_t<const Compute_t&, Args&...>>;
+        Result_t result = Lookup<Result_t>(args...);
+        if constexpr (std::is_same_v<Apply_t, std::nullptr_t>)
+        {
+            return result;
+        }
+        else
+        {
+            return std::invoke(m_apply, result, args...);
+        }
+    }
+
+    template<class... Args>
+        requires std::is_invocable_v<const Key_t&, Args&...> && std::is_invocable_v<const Compute_t&, Args&...>
+    decltype(auto) operator()(Args&... args) const
+    {
+        return Execute(args...);
+    }
+
+    // Empties the caches. Not thread-safe : the step must not be executed at the same time.
+    void Clear()
+    {
+        if (m_shared.cache)
+        {
+            m_shared.cache->clear();
+        }
+        if (!m_threadCaches)
+        {
+            return;
+        }
+        for (const auto& chunk : m_threadCaches->chunks)
+        {
+            if (ThreadCacheChunk* caches = chunk.load(std::memory_order_acquire))
+            {
+                for (const auto& cache : *caches)
+                {
+                    if (cache)
+                    {
+                        cache->clear();
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // the caches of the threads are allocated by chunks, when a thread of the chunk first executes the step
+    static constexpr std::size_t thread_cache_chunk = 64;
+    static constexpr std::size_t max_thread_cache_chunks = 64;
+
+    template<class... Args>
+    using Cache_t = detail::MemoCache<std::decay_t<std::invoke_result_t<const Key_t&, Args&...>>,
+                                      std::decay_t<std::invoke_result_t<const Compute_t&, Args&...>>>;
+
+    // identifies the type of a cache
+    template<class Cache>
+    static constexpr char cache_type = 0;
+
+    // The caches are type-erased : their types depend on the arguments of the execution. A step executed with
+    // arguments giving other key or result types keeps a cache for each of these types, chained to the first one.
+    struct ErasedCache
+    {
+        std::shared_ptr<void> cache;
+        void (*clearCache)(void*) = nullptr;
+        const void* type = nullptr;
+        std::unique_ptr<ErasedCache> next;
+
+        void clear() const
+        {
+            for (const ErasedCache* erased = this; erased; erased = erased->next.get())
+            {
+                erased->clearCache(erased->cache.get());
+            }
+        }
+    };
+
+    // Returns the cache of type Cache chained from first, created on its first use
+    template<class Cache>
+    Cache& CacheOf(std::unique_ptr<ErasedCache>& first) const
+    {
+        std::unique_ptr<ErasedCache>* erased = &first;
+        while (*erased && (*erased)->type != &cache_type<Cache>)
+        {
+            erased = &(*erased)->next;
+        }
+        if (!*erased)
+        {
+            *erased = std::make_unique<ErasedCache>(ErasedCache{
+                std::make_shared<Cache>(m_options.capacity, m_options.policy),
+                [](void* cache) { static_cast<Cache*>(cache)->clear(); }, &cache_type<Cache>, nullptr });
+        }
+        return *static_cast<Cache*>((*erased)->cache.get());
+    }
+
+    template<class Result, class... Args>
+    Result Lookup(Args&... args) const
+    {
+        using Cache = Cache_t<Args...>;
+        const auto key = std::invoke(m_key, args...);
+
+        if (m_threadCaches)
+        {
+            if (std::unique_ptr<ErasedCache>* cacheOfThread = ThreadCache(detail::thread_index()))
+            {
+                // the cache of a thread is only used by this thread, it is created on its first use
+                Cache& cache = CacheOf<Cache>(*cacheOfThread);
+                if (const Result* cached = cache.find(key))
+                {
+                    return *cached;
+                }
+                Result result = std::invoke(m_compute, args...);
+                cache.insert(key, result);
+                return result;
+            }
+        }
+
+        Cache* cache = nullptr;
+        {
+            std::lock_guard lock(m_shared.mutex);
+            cache = &CacheOf<Cache>(m_shared.cache);
+            if (const Result* cached = cache->find(key))
+            {
+                return *cached;
+            }
+        }
+        Result result = std::invoke(m_compute, args...);
+        std::lock_guard lock(m_shared.mutex);
+        cache->insert(key, result);
+        return result;
+    }
+
+    // The cache of the thread of this index, null beyond the last chunk
+    std::unique_ptr<ErasedCache>* ThreadCache(std::size_t index) const
+    {
+        const std::size_t chunk = index / thread_cache_chunk;
+        if (chunk >= max_thread_cache_chunks)
+        {
+            return nullptr;
+        }
+        std::atomic<ThreadCacheChunk*>& slot = m_threadCaches->chunks[chunk];
+        ThreadCacheChunk* caches = slot.load(std::memory_order_acquire);
+        if (!caches)
+        {
+            // the threads of the chunk may race to create it : the first one wins
+            auto created = std::make_unique<ThreadCacheChunk>();
+            if (slot.compare_exchange_strong(caches, created.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                caches = created.release();
+            }
+        }
+        return &(*caches)[index % thread_cache_chunk];
+    }
+
+    Key_t m_key;
+    Compute_t m_compute;
+    [[no_unique_address]] Apply_t m_apply;
+    MemoizeOptions m_options;
+
+    // the caches are filled by executions of a const step
+    struct SharedCache
+    {
+        std::mutex mutex;
+        std::unique_ptr<ErasedCache> cache;
+    };
+    mutable SharedCache m_shared;
+    using ThreadCacheChunk = std::array<std::unique_ptr<ErasedCache>, thread_cache_chunk>;
+    struct ThreadCaches
+    {
+        ThreadCaches() = default;
+        ThreadCaches(const ThreadCaches&) = delete;
+        ThreadCaches& operator=(const ThreadCaches&) = delete;
+
+        ~ThreadCaches()
+        {
+            for (auto& chunk : chunks)
+            {
+                delete chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::array<std::atomic<ThreadCacheChunk*>, max_thread_cache_chunks> chunks{};
+    };
+    // indexed by detail::thread_index, null unless threadLocal
+    std::unique_ptr<ThreadCaches> m_threadCaches;
+};
+
+// Memoize(key, compute) : see MemoizeStep
+template<class KeyT, class ComputeT>
+auto Memoize(KeyT&& key, ComputeT&& compute, MemoizeOptions options = {})
+{
+    return MemoizeStep<std::decay_t<KeyT>, std::decay_t<ComputeT>, std::nullptr_t>(
+        std::forward<KeyT>(key), std::forward<ComputeT>(compute), nullptr, options);
+}
+
+// Memoize(key, compute, apply) : see MemoizeStep
+template<class KeyT, class ComputeT, class ApplyT,
+         std::enable_if_t<!std::is_same_v<std::decay_t<ApplyT>, MemoizeOptions>, bool> = true>
+auto Memoize(KeyT&& key, ComputeT&& compute, ApplyT&& apply, MemoizeOptions options = {})
+{
+    return MemoizeStep<std::decay_t<KeyT>, std::decay_t<ComputeT>, std::decay_t<ApplyT>>(
+        std::forward<KeyT>(key), std::forward<ComputeT>(compute), std::forward<ApplyT>(apply), options);
+}
+
+} // namespace chain
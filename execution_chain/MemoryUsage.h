@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <typeinfo>
+#include <vector>
+
+namespace chain
+{
+
+// Memory held by a block of a chain (or by an action of a BlockTuple)
+struct BlockMemory
+{
+    // position of the block in the chain
+    std::size_t index = 0;
+    // type of the stored block, see std::type_info::name. Null for the actions of a BlockTuple built without RTTI.
+    const std::type_info* type = nullptr;
+    // bytes of the block : its action, and its statistics when the instrumentation is enabled
+    std::size_t size = 0;
+    // bytes spent to reach the block : its dispatch entry, its arena record and the padding before it
+    std::size_t overhead = 0;
+    // the block is stored in a segment shared with other chains (or frozen copies)
+    bool shared = false;
+};
+
+/**
+ * \brief MemoryUsage is the memory footprint of a chain, as returned by memory_usage() : the bytes of each
+ * block, the bookkeeping of the chain and the slack, the bytes allocated but not used yet.
+ * \code{.cpp}
+ *    const MemoryUsage usage = chain.memory_usage();
+ *    for (const BlockMemory& block : usage.blocks) { log(block.index, block.type->name(), block.size); }
+ *    if (usage.slack > usage.actions) { chain.compact(); }
+ * \endcode
+ * \details The shared segments are counted in full by every chain sharing them. The control blocks of the
+ * shared pointers and the chain object itself are not counted.
+*/
+struct MemoryUsage
+{
+    std::vector<BlockMemory> blocks;
+    // number of separate allocations of blocks (one per segment of an ExecutionChain)
+    std::size_t segments = 0;
+    // sum of the sizes of the blocks
+    std::size_t actions = 0;
+    // sum of the overheads of the blocks, and the bookkeeping of the segments
+    std::size_t overhead = 0;
+    // allocated capacity which holds no block
+    std::size_t slack = 0;
+
+    std::size_t total() const noexcept
+    {
+        return actions + overhead + slack;
+    }
+};
+
+} // namespace chain
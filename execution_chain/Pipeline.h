@@ -0,0 +1,249 @@
+#pragma once
+
+#include "ExecutionChain.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace chain
+{
+
+struct PipelineOptions
+{
+    // capacity of each queue between two stages, a full queue blocks the stage feeding it
+    std::size_t queueCapacity = 1024;
+
+    // cores[i] is the core the i-th stage is pinned to, stages without a core are not pinned
+    std::vector<int> cores;
+
+    // the contexts leaving the last stage are queued for Pop / TryPop, instead of being destroyed
+    bool collectOutput = false;
+};
+
+/**
+ * \brief A Pipeline runs a sequence of stages over a stream of contexts, each stage on its own thread. <br>
+ * The contexts move from a stage to the next one through bounded lock-free single-producer single-consumer queues.
+ * A stage is anything an ExecutionChain<Context&> can be built from : an ExecutionChain, a BlockTuple or an action.
+ * \code{.cpp}
+ *    Pipeline<Message> pipeline(PipelineOptions{ .queueCapacity = 256, .cores = { 2, 3, 4 } },
+ *                               start_chain | Parse() | Validate(),
+ *                               Enrich(),
+ *                               Store());
+ *    for (auto& message : messages) { pipeline.Push(std::move(message)); }
+ *    pipeline.Drain(); // every message went through the 3 stages
+ * \endcode
+ *
+ * \details Push and TryPush must be called from a single producer thread, Pop and TryPop from a single consumer
+ * thread. <br>
+ * Backpressure : TryPush fails when the queue of the first stage is full, Push waits until it is not. A stage
+ * waits in the same way when the queue of the next stage is full, so that a slow stage throttles the producer. <br>
+ * Shutdown stops accepting contexts, lets the stages process the queued ones and joins their threads.
+ * The destructor shuts the pipeline down. With collectOutput, the output keeps the contexts it holds at the
+ * shutdown for Pop and TryPop, the next ones are destroyed when it is full. <br>
+ * The stages run on their own threads and must not throw.
+*/
+template <class Context>
+class Pipeline
+{
+public:
+    template <class... StagesT>
+    explicit Pipeline(PipelineOptions options, StagesT&&... stages)
+        : m_options(std::move(options))
+    {
+        static_assert(sizeof...(StagesT) > 0, "A pipeline requires at least one stage");
+        m_stages.reserve(sizeof...(StagesT));
+        (m_stages.push_back(std::make_unique<Stage>(ExecutionChain<Context&>(std::forward<StagesT>(stages)),
+                                                    m_options.queueCapacity)), ...);
+        if (m_options.collectOutput) {
+            m_output = std::make_unique<SpscQueue<Context>>(m_options.queueCapacity);
+        }
+
+        try {
+            for (std::size_t i = 0; i < m_stages.size(); ++i) {
+                m_stages[i]->thread = std::thread([this, i] { StageLoop(i); });
+            }
+        }
+        catch (...) {
+            Shutdown();
+            throw;
+        }
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    ~Pipeline()
+    {
+        Shutdown();
+    }
+
+    // Feeds the pipeline, returns false if the queue of the first stage is full
+    template <class ContextT>
+    bool TryPush(ContextT&& context)
+    {
+        assert(!m_closed.load(std::memory_order_relaxed) && "Pipeline : push after shutdown");
+        if (!m_stages.front()->input.try_push(std::forward<ContextT>(context))) {
+            return false;
+        }
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Feeds the pipeline, waits while the queue of the first stage is full
+    void Push(Context context)
+    {
+        for (Backoff backoff; !TryPush(std::move(context)); backoff.Wait()) {}
+    }
+
+    // Returns the next context which left the last stage, if any (collectOutput only)
+    std::optional<Context> TryPop()
+    {
+        assert(m_output && "Pipeline : the output is not collected");
+        return m_output->try_pop();
+    }
+
+    // Waits for the next context leaving the last stage (collectOutput only)
+    Context Pop()
+    {
+        Backoff backoff;
+        for (std::optional<Context> context = TryPop(); ; context = TryPop(), backoff.Wait()) {
+            if (context) {
+                return std::move(*context);
+            }
+        }
+    }
+
+    // Waits until every pushed context left the last stage
+    void Drain()
+    {
+        const std::size_t pushed = m_pushed.load(std::memory_order_relaxed);
+        for (Backoff backoff; m_completed.load(std::memory_order_acquire) < pushed; backoff.Wait()) {}
+    }
+
+    // Stops accepting contexts, processes the queued ones and joins the stages. Can be called more than once.
+    void Shutdown()
+    {
+        m_closed.store(true, std::memory_order_release);
+        for (auto& stage : m_stages) {
+            if (stage->thread.joinable()) {
+                stage->thread.join();
+            }
+        }
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_stages.size();
+    }
+
+private:
+    struct Stage
+    {
+        Stage(ExecutionChain<Context&> stageChain, std::size_t capacity)
+            : chain(std::move(stageChain)), input(capacity) {}
+
+        ExecutionChain<Context&> chain;
+        SpscQueue<Context> input;
+        std::atomic<bool> finished{ false };
+        std::thread thread;
+    };
+
+    // Spins for a while, then yields the thread
+    struct Backoff
+    {
+        void Wait() noexcept
+        {
+            if (spins < 64) {
+                ++spins;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        int spins = 0;
+    };
+
+    static void PinCurrentThread(int core) noexcept
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)core;
+#endif
+    }
+
+    // the input of the stage is over when the upstream (producer or previous stage) is done and the queue is empty
+    bool IsUpstreamDone(std::size_t index) const noexcept
+    {
+        return index == 0 ? m_closed.load(std::memory_order_acquire)
+                          : m_stages[index - 1]->finished.load(std::memory_order_acquire);
+    }
+
+    void Forward(std::size_t index, Context&& context)
+    {
+        if (index + 1 < m_stages.size()) {
+            for (Backoff backoff; !m_stages[index + 1]->input.try_push(std::move(context)); backoff.Wait()) {}
+            return;
+        }
+
+        // once the pipeline is shut down, the contexts which do not fit in the full output are destroyed :
+        // the consumer may never pop them
+        if (m_output) {
+            for (Backoff backoff; !m_output->try_push(std::move(context)); backoff.Wait()) {
+                if (m_closed.load(std::memory_order_acquire)) {
+                    break;
+                }
+            }
+        }
+        m_completed.fetch_add(1, std::memory_order_release);
+    }
+
+    void StageLoop(std::size_t index)
+    {
+        if (index < m_options.cores.size()) {
+            PinCurrentThread(m_options.cores[index]);
+        }
+
+        Stage& stage = *m_stages[index];
+        Backoff backoff;
+        for (;;) {
+            if (std::optional<Context> context = stage.input.try_pop()) {
+                stage.chain(*context);
+                Forward(index, std::move(*context));
+                backoff = {};
+            }
+            else if (IsUpstreamDone(index) && stage.input.empty()) {
+                break;
+            }
+            else {
+                backoff.Wait();
+            }
+        }
+        stage.finished.store(true, std::memory_order_release);
+    }
+
+    PipelineOptions m_options;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    std::unique_ptr<SpscQueue<Context>> m_output;
+
+    std::atomic<bool> m_closed{ false };
+    std::atomic<std::size_t> m_pushed{ 0 };
+    std::atomic<std::size_t> m_completed{ 0 };
+};
+
+} // namespace chain
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "BlockArena.h"
+#include "ExecutionChain.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace chain
+{
+
+template <class Policy, class... Args>
+class BasicReplicatedChain;
+
+template <class... Args>
+using ReplicatedChain = BasicReplicatedChain<ExecutionPolicy::RunToEnd, Args...>;
+
+namespace detail
+{
+
+// Rounds the allocations up to whole cache lines : the memory of a replica never shares a line with another one
+class CacheLineResource : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t cache_line = 64;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        return std::pmr::new_delete_resource()->allocate(align_up(bytes, cache_line), std::max(alignment, cache_line));
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, align_up(bytes, cache_line), std::max(alignment, cache_line));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace detail
+
+/**
+ * \brief A ReplicatedChain executes one logical chain from many threads, each execution running its own copy
+ * of the chain (a replica) : the stateful actions, like TryFallback or functors with scratch state, are never
+ * shared by two executions running at the same time.
+ * \code{.cpp}
+ *    ReplicatedChain<Pod&> chain(start_chain | Try(Shield()).Fallback(Steer()) | CountCollisions());
+ *    pool.ParallelFor(pods.size(), 64, [&](std::size_t begin, std::size_t end) {
+ *        for (std::size_t i = begin; i < end; ++i) { chain(pods[i]); }
+ *    });
+ *    long collisions = 0;
+ *    chain.Merge([&](ExecutionChain<Pod&>& replica) {
+ *        replica.Visit<CountCollisions>([&](CountCollisions& count) { collisions += count.value; count.value = 0; });
+ *    });
+ * \endcode
+ *
+ * \details The replicas are copies of the prototype, built on first use by the copy constructor of
+ * ExecutionChain. Each replica and its blocks are stored on cache lines of their own, the blocks of the
+ * prototype must therefore be copyable. <br>
+ * An execution uses the replica of its thread (picked by a thread index), or the next free one if that
+ * replica is busy : a thread usually runs its own replica, without contention. <br>
+ * Merge visits the replicas which were built, at a quiescent point : no execution may be running.
+*/
+template <class Policy, class... Args>
+class BasicReplicatedChain
+{
+public:
+    using Chain_t = BasicExecutionChain<Policy, Args...>;
+
+    explicit BasicReplicatedChain(Chain_t prototype,
+                                  std::size_t replicaCount = std::max(1u, std::thread::hardware_concurrency()))
+        : m_prototype(std::move(prototype))
+        , m_count(std::max<std::size_t>(replicaCount, 1))
+        , m_replicas(std::make_unique<Replica[]>(m_count))
+    {}
+
+    BasicReplicatedChain(const BasicReplicatedChain&) = delete;
+    BasicReplicatedChain& operator=(const BasicReplicatedChain&) = delete;
+
+    // Executes a replica of the chain, safe to call from several threads
+    template<class... ExecArgsT>
+    bool Execute(ExecArgsT&&... args) const
+    {
+        const Lease lease(*this);
+        return lease.replica.chain->Execute(std::forward<ExecArgsT>(args)...);
+    }
+
+    template<class... ExecArgsT>
+    bool operator()(ExecArgsT&&... args) const
+    {
+        return Execute(std::forward<ExecArgsT>(args)...);
+    }
+
+    // Calls merge(replica) with each replica built so far, e.g. to combine the state of their actions
+    // (see ExecutionChain::Visit). No execution may be running.
+    template<class F>
+    void Merge(F&& merge)
+    {
+        for (std::size_t i = 0; i < m_count; ++i) {
+            if (m_replicas[i].chain) {
+                merge(*m_replicas[i].chain);
+            }
+        }
+    }
+
+    const Chain_t& Prototype() const noexcept
+    {
+        return m_prototype;
+    }
+
+    std::size_t ReplicaCount() const noexcept
+    {
+        return m_count;
+    }
+
+private:
+    struct alignas(detail::CacheLineResource::cache_line) Replica
+    {
+        std::atomic<bool> busy{ false };
+        detail::CacheLineResource resource;
+        // built by the first execution which leased the replica
+        std::optional<Chain_t> chain;
+    };
+
+    // Owns a replica for the duration of an execution
+    struct Lease
+    {
+        explicit Lease(const BasicReplicatedChain& self) : replica(acquire(self))
+        {
+            if (!replica.chain) {
+                try {
+                    replica.chain.emplace(self.m_prototype, &replica.resource);
+                }
+                catch (...) {
+                    replica.busy.store(false, std::memory_order_release);
+                    throw;
+                }
+            }
+        }
+
+        ~Lease()
+        {
+            replica.busy.store(false, std::memory_order_release);
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        static Replica& acquire(const BasicReplicatedChain& self)
+        {
+            const std::size_t first = detail::thread_index() % self.m_count;
+            for (std::size_t i = first;;) {
+                Replica& candidate = self.m_replicas[i];
+                if (!candidate.busy.load(std::memory_order_relaxed)
+                    && !candidate.busy.exchange(true, std::memory_order_acquire)) {
+                    return candidate;
+                }
+                i = (i + 1) % self.m_count;
+                if (i == first) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        Replica& replica;
+    };
+
+    Chain_t m_prototype;
+    std::size_t m_count;
+    // leased by the executions of a const chain
+    std::unique_ptr<Replica[]> m_replicas;
+};
+
+} // namespace chain
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+// The error of a failed Result, e.g. `return Failure{ ParseError::MissingField };`
+template<class E>
+struct Failure
+{
+    E error;
+};
+
+template<class E>
+Failure(E) -> Failure<E>;
+
+/**
+ * \brief Result<E> is returned by an action which either succeeds, or fails with an error of type E, without
+ * throwing. For the chain, a failed Result is a block returning false : the error is given to the Fallback of
+ * a Try step, or recorded by the ErrorChannel<E> of the execution.
+ * \code{.cpp}
+ *    auto parse = [](Request& r) -> Result<ParseError> {
+ *        if (r.body.empty()) { return Failure{ ParseError::EmptyBody }; }
+ *        return {};
+ *    };
+ *    ExecutionChain<Request&> chain = start_chain
+ *        | Try(parse).Fallback([](const ParseError& error, Request& r) { r.status = 400; return true; })
+ *        | Reply();
+ * \endcode
+ * \details Any type providing `has_value()` and `error()`, such as std::expected<T, E>, is handled the same way.
+*/
+template<class E>
+class Result
+{
+public:
+    using error_type = E;
+
+    // Success
+    constexpr Result() noexcept = default;
+
+    constexpr Result(Failure<E> failure) noexcept(std::is_nothrow_move_constructible_v<E>)
+        : m_error(std::move(failure.error))
+    {}
+
+    constexpr bool has_value() const noexcept
+    {
+        return !m_error.has_value();
+    }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return has_value();
+    }
+
+    // The result must have failed
+    constexpr const E& error() const& noexcept
+    {
+        return *m_error;
+    }
+
+    constexpr E& error() & noexcept
+    {
+        return *m_error;
+    }
+
+private:
+    std::optional<E> m_error;
+};
+
+// An error recorded by an ErrorChannel, with the position of the block which failed in the executed chain
+template<class E>
+struct ChainError
+{
+    static constexpr std::size_t unknown_block = std::numeric_limits<std::size_t>::max();
+
+    std::size_t block = unknown_block;
+    E error;
+};
+
+template<class E>
+class ErrorChannel;
+
+namespace detail
+{
+
+// The result of an action is checked as an expected value : has_value() tells if it succeeded, error() why not
+template<class R>
+concept expected_like = requires(R& result) {
+    { result.has_value() } -> std::convertible_to<bool>;
+    result.error();
+};
+
+// The error channel of type E of the execution running on this thread, if any
+template<class E>
+ErrorChannel<E>*& current_error_channel() noexcept
+{
+    thread_local ErrorChannel<E>* t_channel = nullptr;
+    return t_channel;
+}
+
+// Called on the failure of a block : the error is recorded by the current channel, and dropped otherwise
+template<class E>
+void raise_error(const E& error)
+{
+    if (ErrorChannel<E>* channel = current_error_channel<E>()) {
+        channel->m_errors.push_back(ChainError<E>{ ChainError<E>::unknown_block, error });
+    }
+}
+
+// Makes the channel the one of the current thread for the duration of an execution
+template<class E>
+class ErrorScope
+{
+public:
+    explicit ErrorScope(ErrorChannel<E>& channel) noexcept
+        : m_channel(channel), m_previous(std::exchange(current_error_channel<E>(), &channel))
+        , m_first(channel.m_errors.size())
+    {}
+
+    ~ErrorScope()
+    {
+        current_error_channel<E>() = m_previous;
+    }
+
+    ErrorScope(const ErrorScope&) = delete;
+    ErrorScope& operator=(const ErrorScope&) = delete;
+
+    // The block at this position returned : the errors raised since the previous block are attributed to it
+    void Leave(std::size_t block) noexcept
+    {
+        for (; m_first < m_channel.m_errors.size(); ++m_first) {
+            m_channel.m_errors[m_first].block = block;
+        }
+    }
+
+private:
+    ErrorChannel<E>& m_channel;
+    ErrorChannel<E>* m_previous;
+    std::size_t m_first;
+};
+
+} // namespace detail
+
+/**
+ * \brief An ErrorChannel<E> collects the errors E of the blocks which failed during `chain.Execute(channel, args...)`,
+ * with the position of each failed block. Nothing is unwound : a ShortCircuit chain stops at the failed block,
+ * a RunToEnd chain executes the next blocks.
+ * \code{.cpp}
+ *    ErrorChannel<ParseError> errors;
+ *    if (!chain.Execute(errors, request)) {
+ *        for (const ChainError<ParseError>& e : errors.Errors()) { log(e.block, e.error); }
+ *    }
+ * \endcode
+ * \details The errors handled by the Fallback of a Try step are not recorded. An error is attributed to its block
+ * once the block returned : the successful executions only pay for the test of the results and of the error count. <br>
+ * Clear keeps the capacity of the list, a channel reused at every execution does not allocate once it got large
+ * enough. A channel must not be used by two executions at the same time.
+*/
+template<class E>
+class ErrorChannel
+{
+public:
+    const std::vector<ChainError<E>>& Errors() const noexcept
+    {
+        return m_errors;
+    }
+
+    bool Empty() const noexcept
+    {
+        return m_errors.empty();
+    }
+
+    void Clear() noexcept
+    {
+        m_errors.clear();
+    }
+
+private:
+    std::vector<ChainError<E>> m_errors;
+
+    template<class T>
+    friend void detail::raise_error(const T&);
+
+    friend class detail::ErrorScope<E>;
+};
+
+} // namespace chain
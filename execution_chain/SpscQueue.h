@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace chain
+{
+
+/**
+ * \brief SpscQueue is a bounded lock-free queue for one producer thread and one consumer thread. <br>
+ * The capacity is rounded up to a power of 2. try_push fails when the queue is full,
+ * try_pop returns an empty optional when the queue is empty.
+ * \code{.cpp}
+ *    SpscQueue<Message> queue(1024);
+ *    queue.try_push(Message{}); // producer thread
+ *    std::optional<Message> message = queue.try_pop(); // consumer thread
+ * \endcode
+ * The producer and the consumer indices live on separate cache lines, and each thread keeps a cached copy
+ * of the index of the other one : the shared indices are only read when the cached copy says the queue is
+ * full (producer) or empty (consumer).
+*/
+template <class T>
+class SpscQueue
+{
+    static constexpr std::size_t cache_line = 64;
+
+    struct Slot
+    {
+        alignas(T) std::byte bytes[sizeof(T)];
+
+        T* get() noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(bytes));
+        }
+    };
+
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : m_mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+        , m_slots(std::make_unique<Slot[]>(m_mask + 1))
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue()
+    {
+        while (try_pop()) {}
+    }
+
+    // Producer side : returns false if the queue is full
+    template <class U>
+    bool try_push(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_producer.headCache > m_mask)
+        {
+            m_producer.headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_producer.headCache > m_mask)
+            {
+                return false;
+            }
+        }
+
+        ::new (m_slots[tail & m_mask].bytes) T(std::forward<U>(value));
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side : returns an empty optional if the queue is empty
+    std::optional<T> try_pop() noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_consumer.tailCache)
+        {
+            m_consumer.tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_consumer.tailCache)
+            {
+                return std::nullopt;
+            }
+        }
+
+        T* value = m_slots[head & m_mask].get();
+        std::optional<T> result(std::move(*value));
+        value->~T();
+        m_head.store(head + 1, std::memory_order_release);
+        return result;
+    }
+
+    // Approximate when called concurrently with try_push or try_pop
+    bool empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+private:
+    const std::size_t m_mask;
+    const std::unique_ptr<Slot[]> m_slots;
+
+    // written by the consumer only
+    alignas(cache_line) std::atomic<std::size_t> m_head{ 0 };
+    struct { std::size_t tailCache = 0; } m_consumer;
+
+    // written by the producer only
+    alignas(cache_line) std::atomic<std::size_t> m_tail{ 0 };
+    struct { std::size_t headCache = 0; } m_producer;
+};
+
+} // namespace chain
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "ExecutionChain.h"
+#include "ExecutionFlow.h"
+#include "Pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+namespace detail
+{
+
+// Default reset hook of a pooled context : calls context.Reset() when the context provides it
+struct ResetContext
+{
+    template<class Context>
+    void operator()(Context& context) const
+    {
+        if constexpr (requires { context.Reset(); }) {
+            context.Reset();
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * \brief A ContextPool recycles up to `capacity` contexts : Acquire builds a new context only while the pool
+ * did not create all of them yet, Release resets a context and keeps it for the next Acquire.
+ * \details The contexts are acquired and released by a single thread. A context destroyed instead of released
+ * (e.g. while an exception unwinds) frees its slot, from any thread : the pool builds a new context instead.
+*/
+template <class Context, class Reset = detail::ResetContext>
+class ContextPool
+{
+    struct Deleter
+    {
+        void operator()(Context* context) const noexcept
+        {
+            delete context;
+            if (pool) {
+                pool->m_created.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        ContextPool* pool = nullptr;
+    };
+
+public:
+    using Pooled_t = std::unique_ptr<Context, Deleter>;
+
+    explicit ContextPool(std::size_t capacity, Reset reset = {})
+        : m_capacity(std::max<std::size_t>(capacity, 1)), m_reset(std::move(reset))
+    {
+        m_free.reserve(m_capacity);
+    }
+
+    // the contexts refer to their pool
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    // Returns a free context, or null if the capacity contexts are all in use
+    Pooled_t Acquire()
+    {
+        if (!m_free.empty()) {
+            Pooled_t context = std::move(m_free.back());
+            m_free.pop_back();
+            return context;
+        }
+        if (m_created.load(std::memory_order_relaxed) < m_capacity) {
+            Pooled_t context(new Context(), Deleter{ this });
+            m_created.fetch_add(1, std::memory_order_relaxed);
+            return context;
+        }
+        return nullptr;
+    }
+
+    // The context is destroyed if the reset throws. Never allocates : the free list holds the capacity.
+    void Release(Pooled_t context)
+    {
+        m_reset(*context);
+        m_free.push_back(std::move(context));
+    }
+
+    std::size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    // Number of contexts alive, in use or free
+    std::size_t created() const noexcept
+    {
+        return m_created.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::size_t m_capacity;
+    std::atomic<std::size_t> m_created{ 0 };
+    [[no_unique_address]] Reset m_reset;
+    std::vector<Pooled_t> m_free;
+};
+
+/**
+ * \brief A StreamExecutor runs a chain over a stream of inputs, on contexts recycled by a ContextPool. <br>
+ * Run reads each input with the source into a free context, executes the chain on it, gives it to the sink and
+ * returns it to the pool, where it is reset : once the pool built its contexts, the streaming does not allocate
+ * (as long as the source, the chain and the sink reuse the memory held by the contexts).
+ * \code{.cpp}
+ *    StreamExecutor<ExecutionChain<Message&>, Message> executor(start_chain | Parse() | Validate());
+ *    executor.Run([&](Message& message) { return socket.Read(message.buffer); },  // false at the end of the stream
+ *                 [&](Message& message) { output.Write(message.reply); });
+ * \endcode
+ *
+ * \details The chain is an ExecutionChain<Context&> or a BlockTuple, executed by its Execute function.
+ * The results of the chain are held by the context, the reset hook (Context::Reset by default) clears them
+ * while keeping their capacity. <br>
+ * RunPipelined streams the contexts through a Pipeline instead : the chain is its first stage, followed by the
+ * stages given, each on its own thread. The source and the sink run on the calling thread, and the pool bounds
+ * the number of contexts in flight.
+*/
+template <class Chain, class Context, class Reset = detail::ResetContext>
+class StreamExecutor
+{
+public:
+    using Pool_t = ContextPool<Context, Reset>;
+    using Pooled_t = typename Pool_t::Pooled_t;
+
+    explicit StreamExecutor(Chain chain, std::size_t poolSize = 64, Reset reset = {})
+        : m_chain(std::move(chain)), m_pool(poolSize, std::move(reset))
+    {}
+
+    StreamExecutor(const StreamExecutor&) = delete;
+    StreamExecutor& operator=(const StreamExecutor&) = delete;
+
+    // Processes the inputs until source(context) returns false, returns the number of inputs processed.
+    // When the source, the chain or the sink throws, the context is destroyed and the exception propagates.
+    template<class Source, class Sink>
+    std::size_t Run(Source&& source, Sink&& sink)
+    {
+        std::size_t processed = 0;
+        for (;; ++processed) {
+            // the previous context was released : the pool has a free one
+            Pooled_t context = m_pool.Acquire();
+            assert(context && "StreamExecutor : no free context in the pool");
+            const bool read = source(*context);
+            if (read) {
+                m_chain.Execute(*context);
+                sink(*context);
+            }
+            m_pool.Release(std::move(context));
+            if (!read) {
+                return processed;
+            }
+        }
+    }
+
+    // Same as Run, the contexts going through a pipeline made of the chain and the next stages (see Pipeline).
+    // The stages are built from the same types as the stages of a Pipeline<Context>.
+    template<class Source, class Sink, class... StagesT>
+    std::size_t RunPipelined(PipelineOptions options, Source&& source, Sink&& sink, StagesT&&... stages)
+    {
+        constexpr auto dereference = [](Pooled_t& context) -> Context& { return *context; };
+
+        // the output queue holds every context in flight : the last stage never waits for the sink
+        options.queueCapacity = std::max(options.queueCapacity, m_pool.capacity());
+        options.collectOutput = true;
+        Pipeline<Pooled_t> pipeline(std::move(options),
+                                    [this](Pooled_t& context) { m_chain.Execute(*context); },
+                                    Project(dereference, ExecutionChain<Context&>(std::forward<StagesT>(stages)))...);
+
+        const auto complete = [&](Pooled_t context) {
+            sink(*context);
+            m_pool.Release(std::move(context));
+        };
+
+        std::size_t pushed = 0;
+        std::size_t completed = 0;
+        for (;;) {
+            for (std::optional<Pooled_t> done = pipeline.TryPop(); done; done = pipeline.TryPop()) {
+                complete(std::move(*done));
+                ++completed;
+            }
+
+            Pooled_t context = m_pool.Acquire();
+            if (!context) {
+                // every context is in flight
+                complete(pipeline.Pop());
+                ++completed;
+                continue;
+            }
+            if (!source(*context)) {
+                m_pool.Release(std::move(context));
+                break;
+            }
+            pipeline.Push(std::move(context));
+            ++pushed;
+        }
+
+        for (; completed < pushed; ++completed) {
+            complete(pipeline.Pop());
+        }
+        pipeline.Shutdown();
+        return pushed;
+    }
+
+    const Pool_t& Pool() const noexcept
+    {
+        return m_pool;
+    }
+
+private:
+    Chain m_chain;
+    Pool_t m_pool;
+};
+
+} // namespace chain
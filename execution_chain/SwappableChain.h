@@ -0,0 +1,161 @@
+#pragma once
+
+#include "ExecutionChain.h"
+#include "ThreadPool.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace chain
+{
+
+template <class Policy, class... Args>
+class BasicSwappableChain;
+
+template <class... Args>
+using SwappableChain = BasicSwappableChain<ExecutionPolicy::RunToEnd, Args...>;
+
+/**
+ * \brief A SwappableChain holds the current version of a chain, which can be replaced while other threads
+ * execute it. <br>
+ * The readers never wait : each execution registers itself, loads the current version and executes it.
+ * Publish installs a new version atomically, then waits for the executions of the previous version to
+ * finish before destroying it.
+ * \code{.cpp}
+ *    SwappableChain<Race&> strategy(start_chain | Steer() | Thrust());
+ *    // worker threads
+ *    strategy(race);
+ *    // configuration thread
+ *    strategy.Publish(start_chain | Shield() | Thrust());
+ * \endcode
+ *
+ * \details The reclamation is epoch based. An execution increments the reader counter of the current epoch
+ * (in a stripe picked by the thread, on its own cache line), and decrements it once the chain returned.
+ * Publish swaps the version, moves to the next epoch and waits until the counters of the previous epoch
+ * drop to zero : the executions registered afterwards can only have loaded the new version.
+ * An execution retries its registration only if a Publish moved to the next epoch in the meantime. <br>
+ * The writers are serialized, Publish must not be called from an execution of the chain. <br>
+ * As for a shared ExecutionChain, the blocks executed by several threads must be safe to call concurrently.
+*/
+template <class Policy, class... Args>
+class BasicSwappableChain
+{
+public:
+    using Chain_t = BasicExecutionChain<Policy, Args...>;
+
+    explicit BasicSwappableChain(Chain_t chain = {}) : m_current(new Chain_t(std::move(chain))) {}
+
+    BasicSwappableChain(const BasicSwappableChain&) = delete;
+    BasicSwappableChain& operator=(const BasicSwappableChain&) = delete;
+
+    // No execution may be running
+    ~BasicSwappableChain()
+    {
+        delete m_current.load(std::memory_order_relaxed);
+    }
+
+    // Executes the current version of the chain
+    template<class... ExecArgsT>
+    bool Execute(ExecArgsT&&... args) const
+    {
+        const ReadGuard guard(*this);
+        return guard.chain->Execute(std::forward<ExecArgsT>(args)...);
+    }
+
+    template<class... ExecArgsT>
+    bool operator()(ExecArgsT&&... args) const
+    {
+        return Execute(std::forward<ExecArgsT>(args)...);
+    }
+
+    // Returns a copy of the current version (its immutable blocks are shared, see ExecutionChain)
+    Chain_t Load() const
+    {
+        const ReadGuard guard(*this);
+        return *guard.chain;
+    }
+
+    // Installs chain as the current version, and destroys the previous version once no execution uses it
+    void Publish(Chain_t chain)
+    {
+        std::unique_ptr<Chain_t> next = std::make_unique<Chain_t>(std::move(chain));
+        const std::lock_guard lock(m_writer);
+        std::unique_ptr<const Chain_t> previous(m_current.exchange(next.release(), std::memory_order_seq_cst));
+        Synchronize();
+    }
+
+    // Publishes a modified copy of the current version, for instance : Update([](auto& chain) { chain |= Log(); });
+    template<class F>
+    void Update(F&& modify)
+    {
+        const std::lock_guard lock(m_writer);
+        std::unique_ptr<Chain_t> next = std::make_unique<Chain_t>(*m_current.load(std::memory_order_relaxed));
+        std::forward<F>(modify)(*next);
+        std::unique_ptr<const Chain_t> previous(m_current.exchange(next.release(), std::memory_order_seq_cst));
+        Synchronize();
+    }
+
+private:
+    static constexpr std::size_t cache_line = 64;
+    static constexpr std::size_t stripe_count = 64;
+
+    // The reader counters of the two last epochs
+    struct alignas(cache_line) Stripe
+    {
+        std::atomic<std::size_t> readers[2]{};
+    };
+
+    // Registers an execution for as long as it uses the chain
+    struct ReadGuard
+    {
+        explicit ReadGuard(const BasicSwappableChain& self)
+        {
+            Stripe& stripe = self.m_stripes[detail::thread_index() % stripe_count];
+            for (;;) {
+                const std::size_t epoch = self.m_epoch.load(std::memory_order_seq_cst);
+                counter = &stripe.readers[epoch & 1];
+                counter->fetch_add(1, std::memory_order_seq_cst);
+                // a Publish which moved to the next epoch in the meantime may not have seen the registration
+                if (self.m_epoch.load(std::memory_order_seq_cst) == epoch) {
+                    break;
+                }
+                counter->fetch_sub(1, std::memory_order_release);
+            }
+            chain = self.m_current.load(std::memory_order_seq_cst);
+        }
+
+        ~ReadGuard()
+        {
+            counter->fetch_sub(1, std::memory_order_release);
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        std::atomic<std::size_t>* counter;
+        const Chain_t* chain;
+    };
+
+    // Moves to the next epoch and waits for the executions registered in the previous one.
+    // Called with the writer lock, after the current version was swapped.
+    void Synchronize()
+    {
+        const std::size_t previous = m_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+        for (const Stripe& stripe : m_stripes) {
+            while (stripe.readers[previous].load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::atomic<const Chain_t*> m_current;
+    alignas(cache_line) std::atomic<std::size_t> m_epoch{ 0 };
+    mutable std::array<Stripe, stripe_count> m_stripes;
+    std::mutex m_writer;
+};
+
+} // namespace chain
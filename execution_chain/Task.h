@@ -0,0 +1,352 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace chain
+{
+
+template <class T = void>
+class Task;
+
+namespace detail
+{
+
+struct TaskPromiseBase
+{
+    // Resumes the awaiting coroutine once the task is done
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // a task is lazy : it starts when it is awaited
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        error = std::current_exception();
+    }
+
+    void rethrow_if_failed() const
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase
+{
+    Task<T> get_return_object() noexcept;
+
+    template <class U = T>
+    void return_value(U&& value)
+    {
+        result.emplace(std::forward<U>(value));
+    }
+
+    T take_result()
+    {
+        rethrow_if_failed();
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void take_result()
+    {
+        rethrow_if_failed();
+    }
+};
+
+// The awaiter of an awaitable : the result of its operator co_await if it has one, the awaitable itself otherwise
+template <class Awaitable>
+decltype(auto) get_awaiter(Awaitable&& awaitable)
+{
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); })
+    {
+        return std::forward<Awaitable>(awaitable).operator co_await();
+    }
+    else
+    {
+        return std::forward<Awaitable>(awaitable);
+    }
+}
+
+template <class T>
+inline constexpr bool is_awaitable_v = requires(T&& t) { get_awaiter(std::forward<T>(t)).await_ready(); };
+
+template <class T>
+using await_result_t = decltype(get_awaiter(std::declval<T>()).await_resume());
+
+} // namespace detail
+
+/**
+ * \brief Task<T> is a lazy coroutine producing a T : the coroutine starts when the task is awaited,
+ * and resumes the awaiting coroutine when it completes.
+ * \code{.cpp}
+ *    Task<int> Answer() { co_return 42; }
+ *    Task<int> Twice() { co_return 2 * co_await Answer(); }
+ *    int x = sync_wait(Twice()); // --> x = 84
+ * \endcode
+ * An exception escaping the coroutine is rethrown to the awaiting coroutine.
+*/
+template <class T>
+class Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() noexcept = default;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        reset();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !m_handle || m_handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+    T await_resume()
+    {
+        return m_handle.promise().take_result();
+    }
+
+private:
+    void reset() noexcept
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace detail
+{
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+struct SyncWaitState
+{
+    void notify()
+    {
+        // notified under the lock : the waiting thread cannot destroy the state before the notification is done
+        std::lock_guard lock(mutex);
+        done = true;
+        completed.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock lock(mutex);
+        completed.wait(lock, [this] { return done; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    bool done = false;
+};
+
+// Coroutine awaiting the task of sync_wait, signals the waiting thread once it is suspended for the last time
+struct SyncWaitTask
+{
+    struct promise_type
+    {
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+            {
+                handle.promise().state->notify();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        SyncWaitTask get_return_object() noexcept
+        {
+            return SyncWaitTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() noexcept
+        {
+            error = std::current_exception();
+        }
+
+        SyncWaitState* state = nullptr;
+        std::exception_ptr error;
+    };
+
+    explicit SyncWaitTask(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+    SyncWaitTask(const SyncWaitTask&) = delete;
+    SyncWaitTask& operator=(const SyncWaitTask&) = delete;
+
+    ~SyncWaitTask()
+    {
+        handle.destroy();
+    }
+
+    // Runs the coroutine until it completes, possibly on other threads
+    void run()
+    {
+        SyncWaitState state;
+        handle.promise().state = &state;
+        handle.resume();
+        state.wait();
+        if (handle.promise().error)
+        {
+            std::rethrow_exception(handle.promise().error);
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <class T, class ResultT>
+SyncWaitTask make_sync_wait_task(Task<T>& task, ResultT& result)
+{
+    if constexpr (std::is_void_v<T>)
+    {
+        co_await task;
+    }
+    else
+    {
+        result.emplace(co_await task);
+    }
+}
+
+} // namespace detail
+
+// Runs the task and blocks the calling thread until it completes, returns the result of the task
+template <class T>
+T sync_wait(Task<T> task)
+{
+    std::conditional_t<std::is_void_v<T>, std::optional<bool>, std::optional<T>> result;
+    detail::make_sync_wait_task(task, result).run();
+    if constexpr (!std::is_void_v<T>)
+    {
+        return std::move(*result);
+    }
+}
+
+// Awaitable resuming the awaiting coroutine on a thread of the pool
+// \code{.cpp}
+//    co_await ScheduleOn(pool); // the coroutine continues on the pool
+// \endcode
+inline auto ScheduleOn(ThreadPool& pool) noexcept
+{
+    struct ScheduleAwaiter
+    {
+        ThreadPool& pool;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            pool.Submit([handle] { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    return ScheduleAwaiter{ pool };
+}
+
+} // namespace chain
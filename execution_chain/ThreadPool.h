@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chain
+{
+
+namespace detail
+{
+
+// Hands out the smallest free index to a thread, and takes it back when the thread exits :
+// the indices stay below the number of threads alive at the same time.
+class ThreadIndexRegistry
+{
+public:
+    static ThreadIndexRegistry& Instance()
+    {
+        static ThreadIndexRegistry s_registry;
+        return s_registry;
+    }
+
+    std::size_t Acquire()
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_free.empty()) {
+            // keeps Release from allocating
+            m_free.reserve(m_next + 1);
+            return m_next++;
+        }
+        std::pop_heap(m_free.begin(), m_free.end(), std::greater<>{});
+        const std::size_t index = m_free.back();
+        m_free.pop_back();
+        return index;
+    }
+
+    void Release(std::size_t index) noexcept
+    {
+        std::lock_guard lock(m_mutex);
+        m_free.push_back(index);
+        std::push_heap(m_free.begin(), m_free.end(), std::greater<>{});
+    }
+
+private:
+    std::mutex m_mutex;
+    std::size_t m_next = 0;
+    // min-heap of the indices of the threads which exited
+    std::vector<std::size_t> m_free;
+};
+
+struct ThreadIndex
+{
+    ThreadIndex() : value(ThreadIndexRegistry::Instance().Acquire()) {}
+    ~ThreadIndex() { ThreadIndexRegistry::Instance().Release(value); }
+
+    ThreadIndex(const ThreadIndex&) = delete;
+    ThreadIndex& operator=(const ThreadIndex&) = delete;
+
+    const std::size_t value;
+};
+
+// Small index of the current thread, unique among the threads alive. The index of a thread which exited
+// is given to a later thread. Used to pick the per-thread state of a step or a chain.
+inline std::size_t thread_index() noexcept
+{
+    thread_local const ThreadIndex t_index;
+    return t_index.value;
+}
+
+} // namespace detail
+
+/**
+ * \brief ThreadPool is a fixed-size work-stealing thread pool. <br>
+ * The threads are created once by the constructor and joined by the destructor. <br>
+ * Each worker owns a queue of tasks : it runs the tasks of its own queue first (last in, first out)
+ * and steals the oldest tasks of the other workers when its queue is empty.
+ * \code{.cpp}
+ *    ThreadPool pool(4);
+ *    std::vector<int> values(10000);
+ *    pool.ParallelFor(values.size(), 256, [&](std::size_t begin, std::size_t end) {
+ *        for (std::size_t i = begin; i < end; ++i) { values[i] = int(i); }
+ *    });
+ * \endcode
+ */
+class ThreadPool
+{
+    // A task runs fn(context, begin, end), it does not own its context
+    struct Task
+    {
+        void (*fn)(void*, std::size_t, std::size_t);
+        void* context;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct alignas(64) Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // State shared by the chunks of a ParallelFor call, lives on the stack of the caller.
+    // The caller returns once `done` is set : setting it, under the mutex, is the last access of a chunk to the job.
+    template <class F>
+    struct ParallelJob
+    {
+        F& fn;
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        std::exception_ptr error;
+
+        static void Run(void* context, std::size_t begin, std::size_t end)
+        {
+            auto& job = *static_cast<ParallelJob*>(context);
+            try
+            {
+                job.fn(begin, end);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(job.mutex);
+                if (!job.error)
+                {
+                    job.error = std::current_exception();
+                }
+            }
+            job.Complete(1);
+        }
+
+        // Counts `chunks` chunks as done, the last one wakes the caller up
+        void Complete(std::size_t chunks) noexcept
+        {
+            if (remaining.fetch_sub(chunks, std::memory_order_acq_rel) == chunks)
+            {
+                std::lock_guard lock(mutex);
+                done = true;
+                finished.notify_all();
+            }
+        }
+
+        void WaitDone()
+        {
+            std::unique_lock lock(mutex);
+            finished.wait(lock, [this] { return done; });
+        }
+    };
+
+public:
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency())
+        : m_workers(std::max<std::size_t>(threadCount, 1))
+    {
+        m_threads.reserve(m_workers.size());
+        for (std::size_t i = 0; i < m_workers.size(); ++i)
+        {
+            m_threads.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_sleepMutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Pool shared by the library features which are not given an explicit pool
+    static ThreadPool& Default()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    // Runs task on one of the workers, the pool must outlive the task
+    template <class F>
+    void Submit(F&& task)
+    {
+        using Task_t = std::decay_t<F>;
+        auto pTask = std::make_unique<Task_t>(std::forward<F>(task));
+        Push({ [](void* context, std::size_t, std::size_t)
+               {
+                   std::unique_ptr<Task_t> owned(static_cast<Task_t*>(context));
+                   (*owned)();
+               },
+               pTask.get(), 0, 0 });
+        pTask.release();
+    }
+
+    // Calls fn(begin, end) over chunks of [0, count) of at most grain elements, in parallel,
+    // and returns once every chunk is done. The calling thread executes chunks as well.
+    // The first exception thrown by fn is rethrown once all the chunks are done. If a chunk cannot be queued,
+    // the queued chunks are waited for and the exception is rethrown.
+    template <class F>
+    void ParallelFor(std::size_t count, std::size_t grain, F&& fn)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        grain = std::max<std::size_t>(grain, 1);
+        const std::size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1)
+        {
+            fn(std::size_t{ 0 }, count);
+            return;
+        }
+
+        ParallelJob<std::remove_reference_t<F>> job{ fn, chunks, {}, {}, false, {} };
+        // the first chunk is kept for the calling thread
+        std::size_t chunk = 1;
+        try
+        {
+            for (; chunk < chunks; ++chunk)
+            {
+                const std::size_t begin = chunk * grain;
+                Push({ &decltype(job)::Run, &job, begin, std::min(begin + grain, count) });
+            }
+        }
+        catch (...)
+        {
+            // the queued chunks refer to the job : they are waited for, the others are never run
+            job.Complete(chunks - chunk + 1);
+            Await(job);
+            throw;
+        }
+        decltype(job)::Run(&job, 0, std::min(grain, count));
+        Await(job);
+
+        if (job.error)
+        {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+    // Grain used when none is provided : about 4 chunks per thread (workers and caller)
+    std::size_t DefaultGrain(std::size_t count) const noexcept
+    {
+        return std::max<std::size_t>(1, count / (4 * (size() + 1)));
+    }
+
+private:
+    // Helps the workers while chunks of the job are queued, then waits for the last chunk to be done
+    template <class Job>
+    void Await(Job& job)
+    {
+        while (job.remaining.load(std::memory_order_acquire) != 0)
+        {
+            Task task;
+            if (!TryPop(CurrentWorker(), task))
+            {
+                break;
+            }
+            task.fn(task.context, task.begin, task.end);
+        }
+        job.WaitDone();
+    }
+
+    static constexpr std::size_t no_worker = static_cast<std::size_t>(-1);
+
+    // index of the worker running on the current thread, no_worker if the thread does not belong to this pool
+    std::size_t CurrentWorker() const noexcept
+    {
+        return t_pool == this ? t_workerIndex : no_worker;
+    }
+
+    void Push(const Task& task)
+    {
+        // a worker pushes in its own queue, other threads spread the tasks over the workers
+        std::size_t index = CurrentWorker();
+        if (index == no_worker)
+        {
+            index = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        }
+
+        {
+            std::lock_guard lock(m_workers[index].mutex);
+            m_workers[index].tasks.push_back(task);
+        }
+
+        // seq_cst : either this thread sees the sleeping worker, or the worker sees the pending task
+        m_pending.fetch_add(1);
+        if (m_sleepers.load() != 0)
+        {
+            // the worker is either waiting, or will see the pending task before waiting
+            { std::lock_guard lock(m_sleepMutex); }
+            m_wakeUp.notify_one();
+        }
+    }
+
+    // Pops a task from the queue of worker `self` (newest first), or steals one from another worker (oldest first)
+    bool TryPop(std::size_t self, Task& task)
+    {
+        const std::size_t count = m_workers.size();
+        if (self != no_worker && TryTake(m_workers[self], task, false))
+        {
+            return true;
+        }
+
+        const std::size_t start = self == no_worker ? m_nextWorker.load(std::memory_order_relaxed) : self + 1;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::size_t victim = (start + i) % count;
+            if (victim != self && TryTake(m_workers[victim], task, true))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TryTake(Worker& worker, Task& task, bool steal)
+    {
+        {
+            std::lock_guard lock(worker.mutex);
+            if (worker.tasks.empty())
+            {
+                return false;
+            }
+
+            if (steal)
+            {
+                task = worker.tasks.front();
+                worker.tasks.pop_front();
+            }
+            else
+            {
+                task = worker.tasks.back();
+                worker.tasks.pop_back();
+            }
+        }
+
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void WorkerLoop(std::size_t index)
+    {
+        t_pool = this;
+        t_workerIndex = index;
+
+        for (;;)
+        {
+            Task task;
+            if (TryPop(index, task))
+            {
+                task.fn(task.context, task.begin, task.end);
+                continue;
+            }
+
+            std::unique_lock lock(m_sleepMutex);
+            m_sleepers.fetch_add(1);
+            m_wakeUp.wait(lock, [this] { return m_stop || m_pending.load() != 0; });
+            m_sleepers.fetch_sub(1);
+            if (m_stop && m_pending.load() == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<Worker> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_nextWorker{ 0 };
+
+    // number of queued tasks and of workers waiting for one
+    std::atomic<std::size_t> m_pending{ 0 };
+    std::atomic<std::size_t> m_sleepers{ 0 };
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    bool m_stop = false;
+
+    static inline thread_local const ThreadPool* t_pool = nullptr;
+    static inline thread_local std::size_t t_workerIndex = 0;
+};
+
+} // namespace chain
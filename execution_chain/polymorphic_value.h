@@ -21,8 +21,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <exception>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <typeindex>
 #include <type_traits>
 #include <typeinfo>
@@ -76,15 +80,58 @@ struct control_block
 
     CONSTEXPR20 virtual ~control_block() = default;
 
-    CONSTEXPR20 virtual std::unique_ptr<control_block> clone() const = 0;
+    // Copies the control block in storage when it fits in capacity and alignment
+    // (inline storage of a polymorphic_value), on the heap otherwise.
+    CONSTEXPR20 virtual control_block* clone(void* storage, std::size_t capacity, std::size_t alignment) const = 0;
+
+    // Move-constructs the control block in storage. Only called on control blocks which were
+    // constructed inline, therefore known to fit in storage.
+    CONSTEXPR20 virtual control_block* relocate(void* storage) noexcept = 0;
 
     CONSTEXPR20 virtual T* ptr() = 0;
 
     CONSTEXPR23 virtual const std::type_info& type() const = 0;
 };
 
+// Returns true if a control block of type CB may be stored in the inline storage of a polymorphic_value.
+// The control block must be nothrow move constructible to keep polymorphic_value moves noexcept.
+template <class CB>
+constexpr bool fits_inline(std::size_t capacity, std::size_t alignment) noexcept
+{
+    return sizeof(CB) <= capacity && alignof(CB) <= alignment && std::is_nothrow_move_constructible_v<CB>;
+}
+
+// Implements the cloning and relocation of a control block through the copy and move constructors of Derived
+template <class T, class Derived>
+struct cloneable_control_block : public control_block<T>
+{
+    CONSTEXPR20 control_block<T>* clone(void* storage, std::size_t capacity, std::size_t alignment) const override
+    {
+        const auto& self = static_cast<const Derived&>(*this);
+        if (fits_inline<Derived>(capacity, alignment))
+        {
+            return ::new (storage) Derived(self);
+        }
+        return new Derived(self);
+    }
+
+    CONSTEXPR20 control_block<T>* relocate(void* storage) noexcept override
+    {
+        if constexpr (std::is_nothrow_move_constructible_v<Derived>)
+        {
+            return ::new (storage) Derived(std::move(static_cast<Derived&>(*this)));
+        }
+        else
+        {
+            // never inlined, see fits_inline
+            assert(false && "polymorphic_value : relocating a control block which cannot be stored inline.");
+            return nullptr;
+        }
+    }
+};
+
 template <class T, class U>
-class direct_control_block : public control_block<T>
+class direct_control_block : public cloneable_control_block<T, direct_control_block<T, U>>
 {
     static_assert(!std::is_reference_v<U>, "");
     U u_;
@@ -101,12 +148,10 @@ public:
     {
     }
 
-    CONSTEXPR20 ~direct_control_block() override = default;
+    CONSTEXPR20 direct_control_block(const direct_control_block&) = default;
+    CONSTEXPR20 direct_control_block(direct_control_block&&) noexcept(std::is_nothrow_move_constructible_v<U>) = default;
 
-    CONSTEXPR20 std::unique_ptr<control_block<T>> clone() const override
-    {
-        return std::make_unique<direct_control_block>(*this);
-    }
+    CONSTEXPR20 ~direct_control_block() override = default;
 
     CONSTEXPR20 T* ptr() override
     {
@@ -120,7 +165,8 @@ public:
 };
 
 template <class T, class U, class Copier = default_copy<U>, class Deleter = std::default_delete<U>>
-class pointer_control_block : public control_block<T>, public Copier
+class pointer_control_block : public cloneable_control_block<T, pointer_control_block<T, U, Copier, Deleter>>
+                            , public Copier
 {
     std::unique_ptr<U, Deleter> p_;
 
@@ -137,15 +183,20 @@ public:
     {
     }
 
-    CONSTEXPR20 ~pointer_control_block() override = default;
-
-    CONSTEXPR20 std::unique_ptr<control_block<T>> clone() const override
+    // Deep copy : the pointed object is copied through the Copier
+    CONSTEXPR20 pointer_control_block(const pointer_control_block& other)
+        : Copier(static_cast<const Copier&>(other))
+        , p_(nullptr, other.p_.get_deleter())
     {
-        assert(p_ && "polymorphic_value : pointer_control_block does not encapsulate data.");
-        return std::make_unique<pointer_control_block>(Copier::operator()(*p_), static_cast<const Copier&>(*this),
-                                                       p_.get_deleter());
+        assert(other.p_ && "polymorphic_value : pointer_control_block does not encapsulate data.");
+        p_.reset(Copier::operator()(*other.p_));
     }
 
+    CONSTEXPR20 pointer_control_block(pointer_control_block&&) noexcept(
+        std::is_nothrow_move_constructible_v<Copier> && std::is_nothrow_move_constructible_v<Deleter>) = default;
+
+    CONSTEXPR20 ~pointer_control_block() override = default;
+
     CONSTEXPR20 T* ptr() override
     {
         return p_.get();
@@ -157,32 +208,133 @@ public:
     }
 };
 
+// Holds a U allocated from a memory resource, the copies of the control block are allocated from the same resource
 template <class T, class U>
-class delegating_control_block : public control_block<T>
+class resource_control_block : public cloneable_control_block<T, resource_control_block<T, U>>
 {
-    std::unique_ptr<control_block<U>> delegate_;
+    static_assert(!std::is_reference_v<U>, "");
+    U u_;
+    std::pmr::memory_resource* resource_;
 
 public:
-    constexpr explicit delegating_control_block(std::unique_ptr<control_block<U>> b)
-        : delegate_(std::move(b))
+    template <class... Ts>
+    constexpr explicit resource_control_block(std::pmr::memory_resource* resource, Ts&&... args)
+        : u_(std::forward<Ts>(args)...)
+        , resource_(resource)
     {
     }
 
-    CONSTEXPR20 ~delegating_control_block() override = default;
+    CONSTEXPR20 resource_control_block(const resource_control_block&) = default;
+    CONSTEXPR20 resource_control_block(resource_control_block&&) noexcept(std::is_nothrow_move_constructible_v<U>) = default;
+
+    CONSTEXPR20 ~resource_control_block() override = default;
+
+    // Allocates the control block from resource
+    template <class... Ts>
+    static resource_control_block* create(std::pmr::memory_resource* resource, Ts&&... args)
+    {
+        void* p = resource->allocate(sizeof(resource_control_block), alignof(resource_control_block));
+#if __cpp_exceptions
+        try
+        {
+            return ::new (p) resource_control_block(resource, std::forward<Ts>(args)...);
+        }
+        catch (...)
+        {
+            resource->deallocate(p, sizeof(resource_control_block), alignof(resource_control_block));
+            throw;
+        }
+#else
+        return ::new (p) resource_control_block(resource, std::forward<Ts>(args)...);
+#endif
+    }
+
+    // Called by the deletion of a heap control block : the memory is returned to the resource
+    void operator delete(resource_control_block* p, std::destroying_delete_t)
+    {
+        std::pmr::memory_resource* resource = p->resource_;
+        p->~resource_control_block();
+        resource->deallocate(p, sizeof(resource_control_block), alignof(resource_control_block));
+    }
+
+    CONSTEXPR20 control_block<T>* clone(void* storage, std::size_t capacity, std::size_t alignment) const override
+    {
+        if (fits_inline<resource_control_block>(capacity, alignment))
+        {
+            return ::new (storage) resource_control_block(*this);
+        }
+        return create(resource_, u_);
+    }
+
+    CONSTEXPR20 T* ptr() override
+    {
+        return std::addressof(u_);
+    }
+
+    CONSTEXPR20 const std::type_info& type() const override
+    {
+        return typeid(u_);
+    }
+};
 
-    CONSTEXPR20 std::unique_ptr<control_block<T>> clone() const override
+// Exposes a polymorphic_value<U, ...> holding a class derived from T as a control_block<T>
+template <class T, class PolymorphicValueU>
+class delegating_control_block : public cloneable_control_block<T, delegating_control_block<T, PolymorphicValueU>>
+{
+    PolymorphicValueU delegate_;
+
+public:
+    template <class V>
+    constexpr explicit delegating_control_block(V&& p)
+        : delegate_(std::forward<V>(p))
     {
-        return std::make_unique<delegating_control_block>(delegate_->clone());
     }
 
+    CONSTEXPR20 delegating_control_block(const delegating_control_block&) = default;
+    CONSTEXPR20 delegating_control_block(delegating_control_block&&) noexcept = default;
+
+    CONSTEXPR20 ~delegating_control_block() override = default;
+
     CONSTEXPR20 T* ptr() override
     {
-        return delegate_->ptr();
+        return delegate_.get();
     }
 
     CONSTEXPR23 const std::type_info& type() const override
     {
-        return delegate_ ? delegate_->type() : typeid(void);
+        return delegate_.type();
+    }
+};
+
+// Inline buffer of a polymorphic_value, empty when Size is 0
+template <std::size_t Size, std::size_t Align>
+struct inline_storage
+{
+    alignas(Align) std::byte bytes_[Size];
+
+    void* data() noexcept
+    {
+        return bytes_;
+    }
+
+    bool contains(const void* p) const noexcept
+    {
+        const auto* b = static_cast<const std::byte*>(p);
+        return !std::less<const std::byte*>{}(b, bytes_) && std::less<const std::byte*>{}(b, bytes_ + Size);
+    }
+};
+
+template <std::size_t Align>
+struct inline_storage<0, Align>
+{
+    void* data() noexcept
+    {
+        return nullptr;
+    }
+
+    constexpr bool contains(const void*) const noexcept
+    {
+        return false;
     }
 };
 
@@ -200,7 +352,23 @@ public:
     }
 };
 
-template <class T>
+namespace detail
+{
+
+// Reports a construction from an object whose dynamic type is not its static type. Without exceptions
+// (-fno-exceptions), the mismatch asserts and the polymorphic_value is left empty.
+inline void report_bad_construction()
+{
+#if __cpp_exceptions
+    throw bad_polymorphic_value_construction();
+#else
+    assert(false && "Dynamic and static type mismatch in polymorphic_value construction");
+#endif
+}
+
+} // end namespace detail
+
+template <class T, std::size_t InlineSize = 0, std::size_t InlineAlign = alignof(std::max_align_t)>
 class polymorphic_value;
 
 template <class T>
@@ -208,8 +376,8 @@ struct is_polymorphic_value : std::false_type
 {
 };
 
-template <class T>
-struct is_polymorphic_value<polymorphic_value<T>> : std::true_type
+template <class T, std::size_t InlineSize, std::size_t InlineAlign>
+struct is_polymorphic_value<polymorphic_value<T, InlineSize, InlineAlign>> : std::true_type
 {
 };
 
@@ -225,8 +393,8 @@ struct polymorphic_value_type
     using type = void;
 };
 
-template <class T>
-struct polymorphic_value_type<polymorphic_value<T>>
+template <class T, std::size_t InlineSize, std::size_t InlineAlign>
+struct polymorphic_value_type<polymorphic_value<T, InlineSize, InlineAlign>>
 {
     using type = T;
 };
@@ -239,8 +407,8 @@ struct is_polymorphic_base : std::false_type
 {
 };
 
-template <class Base, class Derived>
-struct is_polymorphic_base<polymorphic_value<Base>, Derived>
+template <class Base, std::size_t InlineSize, std::size_t InlineAlign, class Derived>
+struct is_polymorphic_base<polymorphic_value<Base, InlineSize, InlineAlign>, Derived>
 {
     inline static constexpr bool value = std::is_base_of_v<Base, Derived>;
 };
@@ -305,14 +473,24 @@ inline constexpr bool is_polymorphic_base_v = is_polymorphic_base<Base, Derived>
  *    auto equals = (p1 == p2); // compiles only if an equality operator between IBase and IBase2 objects exists
  *  \endcode
  *
+ *  -# InlineSize and InlineAlign configure an inline storage : control blocks which fit in InlineSize bytes
+ *   with an alignment up to InlineAlign (and are nothrow move constructible) are stored in the polymorphic_value
+ *   itself instead of being heap-allocated, copies of such values do not allocate either.
+ *   The default InlineSize of 0 disables the inline storage.
+ *  \code{.cpp}
+ *    polymorphic_value<IBase, 32> pvalue = SmallDerived(); // no allocation
+ *    auto copy = pvalue; // no allocation
+ *  \endcode
+ *
  */
-template <class T>
+template <class T, std::size_t InlineSize, std::size_t InlineAlign>
 class polymorphic_value
 {
     static_assert(!std::is_union<T>::value, "");
     static_assert(std::is_class<T>::value, "");
+    static_assert(InlineAlign != 0 && (InlineAlign & (InlineAlign - 1)) == 0, "InlineAlign must be a power of 2");
 
-    template <class U>
+    template <class U, std::size_t S, std::size_t A>
     friend class polymorphic_value;
 
     template <class T_, class U, class... Ts>
@@ -320,14 +498,74 @@ class polymorphic_value
     template <class T_, class... Ts>
     friend CONSTEXPR23 polymorphic_value<T_> make_polymorphic_value(Ts&&... ts);
 
-    std::unique_ptr<detail::control_block<T>> cb_;
+    detail::control_block<T>* cb_ = nullptr;
+    [[no_unique_address]] detail::inline_storage<InlineSize, InlineAlign> storage_;
+
+    // Constructs the control block CB inline when it fits, on the heap otherwise
+    template <class CB, class... Ts>
+    CONSTEXPR23 void emplace_control_block(Ts&&... ts)
+    {
+        if constexpr (detail::fits_inline<CB>(InlineSize, InlineAlign))
+        {
+            cb_ = ::new (storage_.data()) CB(std::forward<Ts>(ts)...);
+        }
+        else
+        {
+            cb_ = new CB(std::forward<Ts>(ts)...);
+        }
+    }
+
+    CONSTEXPR23 bool is_inline() const noexcept
+    {
+        return storage_.contains(cb_);
+    }
+
+    CONSTEXPR23 void reset() noexcept
+    {
+        if (!cb_)
+        {
+            return;
+        }
+
+        if (is_inline())
+        {
+            cb_->~control_block();
+        }
+        else
+        {
+            delete cb_;
+        }
+        cb_ = nullptr;
+    }
+
+    // Takes ownership of the control block of p, this polymorphic_value must be empty
+    CONSTEXPR23 void steal(polymorphic_value& p) noexcept
+    {
+        if (p.is_inline())
+        {
+            cb_ = p.cb_->relocate(storage_.data());
+            p.reset();
+        }
+        else
+        {
+            cb_ = std::exchange(p.cb_, nullptr);
+        }
+    }
+
+    CONSTEXPR23 void copy(const polymorphic_value& p)
+    {
+        cb_ = p.cb_ ? p.cb_->clone(storage_.data(), InlineSize, InlineAlign) : nullptr;
+    }
 
 public:
     //
     // Destructor
     //
 
-    CONSTEXPR20 ~polymorphic_value() = default;
+    CONSTEXPR20 ~polymorphic_value()
+    {
+        reset();
+    }
 
     //
     // Constructors
@@ -353,12 +591,13 @@ public:
         if (std::is_same<D, std::default_delete<U>>::value && std::is_same<C, detail::default_copy<U>>::value &&
             typeid(*u) != typeid(U))
         {
-            throw bad_polymorphic_value_construction();
+            detail::report_bad_construction();
+            return;
         }
 
         std::unique_ptr<U, D> p(u, std::move(deleter));
 
-        cb_ = std::make_unique<detail::pointer_control_block<T, U, C, D>>(std::move(p), std::move(copier));
+        emplace_control_block<detail::pointer_control_block<T, U, C, D>>(std::move(p), std::move(copier));
     }
 
     template <class U, class C = detail::default_copy<U>, class D = std::default_delete<U>,
@@ -373,10 +612,11 @@ public:
         if (std::is_same_v<D, std::default_delete<U>> && std::is_same_v<C, detail::default_copy<U>> &&
             typeid(*u) != typeid(U))
         {
-            throw bad_polymorphic_value_construction();
+            detail::report_bad_construction();
+            return;
         }
 
-        cb_ = std::make_unique<detail::pointer_control_block<T, U, C, D>>(std::move(u), std::move(copier));
+        emplace_control_block<detail::pointer_control_block<T, U, C, D>>(std::move(u), std::move(copier));
     }
 
     template <class U, class V = std::enable_if_t<std::is_convertible<U*, T*>::value>>
@@ -384,10 +624,11 @@ public:
     {
         if (typeid(u) != typeid(U))
         {
-            throw bad_polymorphic_value_construction();
+            detail::report_bad_construction();
+            return;
         }
 
-        cb_ = std::make_unique<detail::direct_control_block<T, remove_cvref_t<U>>>(std::forward<U>(u));
+        emplace_control_block<detail::direct_control_block<T, remove_cvref_t<U>>>(std::forward<U>(u));
     }
 
     template <class U, class V = std::enable_if_t<std::is_convertible_v<U*, T*>>>
@@ -395,10 +636,44 @@ public:
     {
         if (typeid(u) != typeid(U))
         {
-            throw bad_polymorphic_value_construction();
+            detail::report_bad_construction();
+            return;
+        }
+
+        emplace_control_block<detail::direct_control_block<T, U>>(u);
+    }
+
+    // Same as polymorphic_value(u), but a type mismatch leaves the value empty instead of being reported :
+    // polymorphic_value<IBase> pvalue(std::nothrow, base); if (!pvalue) { ... }
+    template <class U, class V = std::enable_if_t<std::is_convertible_v<remove_cvref_t<U>*, T*>>>
+    CONSTEXPR23 polymorphic_value(std::nothrow_t, U&& u)
+    {
+        if (typeid(u) == typeid(remove_cvref_t<U>))
+        {
+            emplace_control_block<detail::direct_control_block<T, remove_cvref_t<U>>>(std::forward<U>(u));
+        }
+    }
+
+    // The object, and the objects of the copies of this polymorphic_value, are allocated from resource
+    // unless they fit in the inline storage. The resource must outlive the value and its copies.
+    template <class U, class V = std::enable_if_t<std::is_convertible_v<remove_cvref_t<U>*, T*>>>
+    CONSTEXPR23 polymorphic_value(std::allocator_arg_t, std::pmr::memory_resource* resource, U&& u)
+    {
+        using CB = detail::resource_control_block<T, remove_cvref_t<U>>;
+        if (typeid(u) != typeid(remove_cvref_t<U>))
+        {
+            detail::report_bad_construction();
+            return;
         }
 
-        cb_ = std::make_unique<detail::direct_control_block<T, U>>(u);
+        if constexpr (detail::fits_inline<CB>(InlineSize, InlineAlign))
+        {
+            cb_ = ::new (storage_.data()) CB(resource, std::forward<U>(u));
+        }
+        else
+        {
+            cb_ = CB::create(resource, std::forward<U>(u));
+        }
     }
 
     //
@@ -406,30 +681,39 @@ public:
     //
 
     CONSTEXPR23 polymorphic_value(const polymorphic_value& p)
-        : cb_(p ? p.cb_->clone() : nullptr)
     {
+        copy(p);
     }
 
     //
     // Move-constructors
     //
 
-    CONSTEXPR23 polymorphic_value(polymorphic_value&& p) noexcept = default;
+    CONSTEXPR23 polymorphic_value(polymorphic_value&& p) noexcept
+    {
+        steal(p);
+    }
 
     //
     // Converting constructors
     //
 
-    template <class U, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
-    explicit CONSTEXPR23 polymorphic_value(const polymorphic_value<U>& p)
-        : cb_(std::make_unique<detail::delegating_control_block<T, U>>(polymorphic_value<U>(p).cb_))
+    template <class U, std::size_t S, std::size_t A, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
+    explicit CONSTEXPR23 polymorphic_value(const polymorphic_value<U, S, A>& p)
     {
+        if (p)
+        {
+            emplace_control_block<detail::delegating_control_block<T, polymorphic_value<U, S, A>>>(p);
+        }
     }
 
-    template <class U, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
-    explicit CONSTEXPR23 polymorphic_value(polymorphic_value<U>&& p)
-        : cb_(std::make_unique<detail::delegating_control_block<T, U>>(std::move(p.cb_)))
+    template <class U, std::size_t S, std::size_t A, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
+    explicit CONSTEXPR23 polymorphic_value(polymorphic_value<U, S, A>&& p)
     {
+        if (p)
+        {
+            emplace_control_block<detail::delegating_control_block<T, polymorphic_value<U, S, A>>>(std::move(p));
+        }
     }
 
     //
@@ -441,8 +725,8 @@ public:
                                          !is_polymorphic_value<std::decay_t<U>>::value>,
               class... Ts>
     CONSTEXPR23 explicit polymorphic_value(std::in_place_type_t<U>, Ts&&... ts)
-        : cb_(std::make_unique<detail::direct_control_block<T, remove_cvref_t<U>>>(std::forward<Ts>(ts)...))
     {
+        emplace_control_block<detail::direct_control_block<T, remove_cvref_t<U>>>(std::forward<Ts>(ts)...);
     }
 
     //
@@ -456,45 +740,28 @@ public:
             return *this;
         }
 
-        if (!p)
-        {
-            cb_.reset();
-            return *this;
-        }
-
-        cb_ = p.cb_->clone();
+        // copied first to keep the current value if the copy throws
+        polymorphic_value copied(p);
+        reset();
+        steal(copied);
         return *this;
     }
 
-    template <typename U, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
-    CONSTEXPR23 polymorphic_value<T>& operator=(const polymorphic_value<U>& p)
+    template <typename U, std::size_t S, std::size_t A, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
+    CONSTEXPR23 polymorphic_value& operator=(const polymorphic_value<U, S, A>& p)
     {
-        if (!p)
-        {
-            cb_.reset();
-            return *this;
-        }
-
-        cb_ = std::make_unique<detail::delegating_control_block<T, U>>(p.cb_->clone());
-        return *this;
+        return *this = polymorphic_value(p);
     }
 
-    template <typename U, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
-    CONSTEXPR23 polymorphic_value<T>& operator=(polymorphic_value<U>&& p)
+    template <typename U, std::size_t S, std::size_t A, std::enable_if_t<is_child_of_v<U, T>, bool> = true>
+    CONSTEXPR23 polymorphic_value& operator=(polymorphic_value<U, S, A>&& p)
     {
-        if (!p)
-        {
-            cb_.reset();
-            return *this;
-        }
-
-        cb_ = std::make_unique<detail::delegating_control_block<T, U>>(std::move(p.cb_));
-        return *this;
+        return *this = polymorphic_value(std::move(p));
     }
 
-    CONSTEXPR23 polymorphic_value<T>& operator=(std::nullptr_t)
+    CONSTEXPR23 polymorphic_value& operator=(std::nullptr_t)
     {
-        cb_.reset();
+        reset();
         return *this;
     }
 
@@ -529,7 +796,15 @@ public:
     // Move-assignment
     //
 
-    CONSTEXPR23 polymorphic_value& operator=(polymorphic_value&& p) noexcept = default;
+    CONSTEXPR23 polymorphic_value& operator=(polymorphic_value&& p) noexcept
+    {
+        if (std::addressof(p) != this)
+        {
+            reset();
+            steal(p);
+        }
+        return *this;
+    }
 
     //
     // Modifiers
@@ -537,7 +812,15 @@ public:
 
     CONSTEXPR23 void swap(polymorphic_value& p) noexcept
     {
-        std::swap(cb_, p.cb_);
+        if (!is_inline() && !p.is_inline())
+        {
+            std::swap(cb_, p.cb_);
+            return;
+        }
+
+        polymorphic_value tmp(std::move(p));
+        p = std::move(*this);
+        *this = std::move(tmp);
     }
 
     //
@@ -633,15 +916,15 @@ public:
     }
 
     template <typename U, std::enable_if_t<is_child_of_v<T, U>, bool> = true>
-    operator polymorphic_value<U>&()
+    operator polymorphic_value<U, InlineSize, InlineAlign>&()
     {
-        return reinterpret_cast<polymorphic_value<U>&>(*this);
+        return reinterpret_cast<polymorphic_value<U, InlineSize, InlineAlign>&>(*this);
     }
 
     template <typename U, std::enable_if_t<is_child_of_v<T, U>, bool> = true>
-    operator const polymorphic_value<U>&() const
+    operator const polymorphic_value<U, InlineSize, InlineAlign>&() const
     {
-        return reinterpret_cast<const polymorphic_value<U>&>(*this);
+        return reinterpret_cast<const polymorphic_value<U, InlineSize, InlineAlign>&>(*this);
     }
 
     template <typename U, std::enable_if_t<!std::is_pointer_v<U>, bool> = true>
@@ -658,14 +941,14 @@ template <class T, class... Ts>
 CONSTEXPR23 polymorphic_value<T> make_polymorphic_value(Ts&&... ts)
 {
     polymorphic_value<T> p;
-    p.cb_ = std::make_unique<detail::direct_control_block<T, T>>(std::forward<Ts>(ts)...);
+    p.template emplace_control_block<detail::direct_control_block<T, T>>(std::forward<Ts>(ts)...);
     return p;
 }
 template <class T, class U, class... Ts>
 CONSTEXPR23 polymorphic_value<T> make_polymorphic_value(Ts&&... ts)
 {
     polymorphic_value<T> p;
-    p.cb_ = std::make_unique<detail::direct_control_block<T, U>>(std::forward<Ts>(ts)...);
+    p.template emplace_control_block<detail::direct_control_block<T, U>>(std::forward<Ts>(ts)...);
     return p;
 }
 
@@ -702,8 +985,9 @@ inline constexpr bool any_polymorphic_value_v = any_polymorphic_value<T...>::val
 //
 // non-member swap
 //
-template <class T>
-CONSTEXPR23 void swap(polymorphic_value<T>& t, polymorphic_value<T>& u) noexcept
+template <class T, std::size_t InlineSize, std::size_t InlineAlign>
+CONSTEXPR23 void swap(polymorphic_value<T, InlineSize, InlineAlign>& t,
+                      polymorphic_value<T, InlineSize, InlineAlign>& u) noexcept
 {
     t.swap(u);
 }
@@ -722,8 +1006,8 @@ inline constexpr bool is_valid(std::nullptr_t)
     return false;
 }
 
-template <typename T>
-CONSTEXPR23 bool is_valid(const polymorphic_value<T>& pvalue)
+template <typename T, std::size_t InlineSize, std::size_t InlineAlign>
+CONSTEXPR23 bool is_valid(const polymorphic_value<T, InlineSize, InlineAlign>& pvalue)
 {
     return bool(pvalue);
 }
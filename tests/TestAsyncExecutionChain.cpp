@@ -0,0 +1,101 @@
+#include "../execution_chain/AsyncExecutionChain.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+struct Context {
+    std::vector<int> steps;
+    std::thread::id thread;
+};
+
+Task<> Record(Context& context, int step) {
+    context.steps.push_back(step);
+    co_return;
+}
+
+// Coroutine started eagerly and destroyed when it completes
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+Detached Detach(const AsyncExecutionChain<Context&>& chain, Context& context, std::atomic<int>& done) {
+    co_await chain(context);
+    ++done;
+}
+
+} // namespace
+
+TEST(AsyncExecutionChainTest, MixesSynchronousAndAsynchronousActions) {
+    AsyncExecutionChain<Context&> chain = start_chain
+        | [](Context& c) { c.steps.push_back(1); }
+        | [](Context& c) { return Record(c, 2); };
+    chain |= [](Context& c) -> Task<bool> { co_await Record(c, 3); co_return true; };
+    chain |= [](Context& c) { c.steps.push_back(4); };
+
+    Context context;
+    EXPECT_TRUE(sync_wait(chain(context)));
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3, 4 }), context.steps);
+    EXPECT_EQ(4u, chain.size());
+}
+
+TEST(AsyncExecutionChainTest, ShortCircuitsOnAsynchronousResults) {
+    AsyncShortCircuitChain<Context&> chain = start_chain
+        | [](Context& c) { c.steps.push_back(1); }
+        | [](Context& c) -> Task<bool> { c.steps.push_back(2); co_return false; }
+        | [](Context& c) { c.steps.push_back(3); };
+
+    Context context;
+    EXPECT_FALSE(sync_wait(chain(context)));
+    EXPECT_EQ((std::vector<int>{ 1, 2 }), context.steps);
+}
+
+TEST(AsyncExecutionChainTest, ResumesOnThePool) {
+    ThreadPool pool(2);
+    AsyncExecutionChain<Context&> chain = start_chain
+        | [&pool](Context&) { return ScheduleOn(pool); }
+        | [](Context& c) { c.thread = std::this_thread::get_id(); };
+
+    // GIVEN many contexts in flight at the same time, started from the calling thread
+    std::vector<Context> contexts(64);
+    std::atomic<int> done{ 0 };
+    for (auto& context : contexts) {
+        Detach(chain, context, done);
+    }
+    while (done.load() != static_cast<int>(contexts.size())) {
+        std::this_thread::yield();
+    }
+
+    // THEN the chains were resumed by the threads of the pool
+    for (const auto& context : contexts) {
+        EXPECT_NE(std::this_thread::get_id(), context.thread);
+    }
+
+    // AND a single context can be awaited from the calling thread
+    Context context;
+    sync_wait(chain(context));
+    EXPECT_NE(std::this_thread::get_id(), context.thread);
+}
+
+TEST(AsyncExecutionChainTest, PropagatesExceptions) {
+    AsyncExecutionChain<Context&> chain = start_chain
+        | [](Context&) -> Task<> { throw std::runtime_error("io failure"); co_return; }
+        | [](Context& c) { c.steps.push_back(1); };
+
+    Context context;
+    EXPECT_THROW(sync_wait(chain(context)), std::runtime_error);
+    EXPECT_TRUE(context.steps.empty());
+}
+
+} // namespace chain
@@ -0,0 +1,84 @@
+#include "../execution_chain/ExecutionChain.h"
+#include "../execution_chain/ExecutionFlow.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+using Trace = std::vector<std::string>;
+
+auto Append(const char* name)
+{
+    return [name](Trace& trace) { trace.push_back(name); };
+}
+
+} // namespace
+
+TEST(DeadlineTest, SkipsTheOptionalBlocksOnceExpired) {
+    // GIVEN a chain whose second block exhausts the budget
+    ExecutionChain<Trace&> chain;
+    chain |= Optional(Append("first"));
+    chain |= [](Trace& trace) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); trace.push_back("slow"); };
+    chain |= Optional(Append("optional"));
+    chain |= Append("mandatory");
+    chain |= Anytime([](Trace& trace, const Deadline&) { trace.push_back("anytime"); });
+
+    // WHEN executed within 1ms
+    Trace trace;
+    Deadline deadline(std::chrono::milliseconds(1));
+    EXPECT_TRUE(chain.Execute(deadline, trace));
+
+    // THEN the optional blocks after the expiration are skipped, the mandatory ones are executed
+    EXPECT_EQ((Trace{ "first", "slow", "mandatory" }), trace);
+    EXPECT_EQ((std::vector<std::size_t>{ 2, 4 }), deadline.Skipped());
+
+    // WHEN executed without a deadline, THEN every block is executed
+    trace.clear();
+    chain(trace);
+    EXPECT_EQ((Trace{ "first", "slow", "optional", "mandatory", "anytime" }), trace);
+}
+
+TEST(DeadlineTest, AnytimeBlocksPollTheDeadline) {
+    // GIVEN an anytime block refining its result until the deadline expires
+    auto refine = Anytime([](int& iterations, const Deadline& deadline) {
+        while (!deadline.Expired()) {
+            ++iterations;
+            std::this_thread::yield();
+        }
+    });
+    auto blockTuple = start_chain | [](int&) {} | refine;
+
+    // WHEN executed within 2ms, checking the clock every 4 polls
+    int iterations = 0;
+    Deadline deadline(std::chrono::milliseconds(2), 4);
+    blockTuple.Execute(deadline, iterations);
+
+    // THEN it stopped at the expiration, and is reported as interrupted
+    EXPECT_GT(iterations, 0);
+    EXPECT_TRUE(deadline.Expired());
+    EXPECT_EQ((std::vector<std::size_t>{ 1 }), deadline.Interrupted());
+
+    // WHEN the deadline is reset, THEN its report is cleared
+    deadline.Reset(std::chrono::hours(1));
+    EXPECT_FALSE(deadline.Expired());
+    EXPECT_TRUE(deadline.Interrupted().empty());
+}
+
+TEST(DeadlineTest, NeverExpiresByDefault) {
+    const Deadline deadline;
+    EXPECT_FALSE(deadline.Expired());
+
+    // AND a ShortCircuit chain stops at a failing mandatory block
+    ShortCircuitChain<int&> chain = start_chain | [](int&) { return false; } | [](int& a) { a = 1; };
+    Deadline budget(std::chrono::hours(1));
+    int x = 0;
+    EXPECT_FALSE(chain.Execute(budget, x));
+    EXPECT_EQ(0, x);
+}
+
+} // namespace chain
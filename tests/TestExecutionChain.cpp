@@ -1,7 +1,19 @@
 #include "../execution_chain/ExecutionChain.h"
 #include "../execution_chain/ExecutionFlow.h"
 #include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <variant>
+#include <vector>
 
 namespace chain {
 
@@ -79,6 +91,61 @@ TEST(ExecutionChainTest, ChainingActionsWithParametersCopy)
     EXPECT_EQ(y, 0);
 }
 
+TEST(ExecutionChainTest, DetectsExpensiveArgumentCopies)
+{
+    struct Race {
+        std::vector<int> pods;
+    };
+    struct TakesCopy {
+        void operator()(Race, int) const {}
+    };
+
+    // THEN the actions copying a large or not trivially copyable argument are detected
+    static_assert(detail::copies_expensive_argument_v<TakesCopy, Race&, int&>);
+    static_assert(detail::copies_expensive_argument_v<void (*)(int, std::array<int, 64>), int&, std::array<int, 64>&>);
+
+    // AND the actions taking their arguments by reference, or copying cheap ones, are not
+    auto byReference = [](Race&, const int&) {};
+    auto cheapCopy = [](const Race&, int) {};
+    static_assert(!detail::copies_expensive_argument_v<decltype(byReference), Race&, int&>);
+    static_assert(!detail::copies_expensive_argument_v<decltype(cheapCopy), Race&, int&>);
+
+    // AND the generic actions cannot be inspected
+    auto generic = [](auto, auto) {};
+    static_assert(!detail::copies_expensive_argument_v<decltype(generic), Race&, int&>);
+}
+
+TEST(ExecutionChainTest, ProjectGivesPartsOfTheContextByReference)
+{
+    struct Pod {
+        int speed = 0;
+    };
+    struct Race {
+        std::vector<Pod> myPods{ 2 };
+        int turn = 0;
+    };
+
+    // GIVEN actions written against the parts of the race they use
+    ExecutionChain<Race&, int&> chain = start_chain
+        | Project(&Race::myPods, [](std::vector<Pod>& pods, int& boost) { for (Pod& pod : pods) { pod.speed += boost; } })
+        | Project([](Race& race) -> Pod& { return race.myPods.back(); }, [](Pod& pod, int&) { pod.speed *= 10; })
+        | Project(&Race::turn, [](int& turn, int&) { return ++turn < 2; });
+
+    // WHEN executed
+    Race race;
+    int boost = 3;
+    EXPECT_TRUE(chain(race, boost));
+
+    // THEN the actions modified the race itself
+    EXPECT_EQ(3, race.myPods[0].speed);
+    EXPECT_EQ(30, race.myPods[1].speed);
+    EXPECT_EQ(1, race.turn);
+
+    // AND the result of the action is the one of the step
+    auto step = Project(&Race::turn, [](int& turn, int&) { return ++turn < 2; });
+    EXPECT_FALSE(step(race, boost));
+}
+
 TEST(ExecutionChainTest, ClearActions)
 {
     //  GIVEN an ExecutionChain object `executionChain` of type `ExecutionChain<int, int>`
@@ -379,4 +446,1004 @@ TEST(ExecutionChainTest, ShouldBeChainable) {
     EXPECT_EQ(42, x);
 }
 
-} // namespace chain
\ No newline at end of file
+TEST(ExecutionChainTest, ShouldHonorActionAlignment) {
+    // GIVEN an action requiring a larger alignment than the default one
+    struct alignas(64) AlignedAction {
+        void operator()(int& a) const {
+            EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(this) % 64);
+            a += value;
+        }
+        int value = 1;
+    };
+
+    // WHEN it is chained after and before smaller actions
+    ExecutionChain<int> chain = start_chain | [](int& a) { a *= 2; } | AlignedAction{} | [](int& a) { a *= 3; };
+    for (int i = 0; i < 20; ++i) {
+        chain |= AlignedAction{};
+    }
+
+    // THEN the blocks are executed in order, each on a properly aligned object
+    int x = 1;
+    chain(x);
+    EXPECT_EQ((1 * 2 + 1) * 3 + 20, x);
+
+    // AND copies keep the alignment
+    ExecutionChain<int> copy = chain;
+    x = 1;
+    copy(x);
+    EXPECT_EQ(29, x);
+}
+
+TEST(ExecutionChainTest, CopiesDoNotShareActionState) {
+    struct Counter {
+        void operator()(int& a) { a = ++count; }
+        int count = 0;
+    };
+
+    ExecutionChain<int> chain = start_chain | Counter{};
+    int x = 0;
+    chain(x);
+    EXPECT_EQ(1, x);
+
+    // WHEN the chain is copied and appended to itself
+    ExecutionChain<int> copy = chain;
+    copy.append(copy);
+    copy(x);
+
+    // THEN the copy starts from the state of the original and both of its counters are independent
+    EXPECT_EQ(2, x);
+
+    // AND the original is not impacted
+    chain(x);
+    EXPECT_EQ(2, x);
+}
+
+TEST(ExecutionChainTest, CopiesShareImmutableBlocks) {
+    static int copies = 0;
+    struct Add {
+        using shareable = std::true_type;
+        Add(int v) : value(v) {}
+        Add(const Add& other) : value(other.value) { ++copies; }
+        void operator()(int& a) const { a += value; }
+        int value;
+    };
+    struct Counter {
+        void operator()(int& a) { a += ++count; }
+        int count = 0;
+    };
+
+    // GIVEN two sub-chains of immutable actions and a sub-chain holding a stateful action
+    ExecutionChain<int> first = start_chain | Add{ 1 } | Add{ 10 };
+    ExecutionChain<int> second = Add{ 100 };
+    ExecutionChain<int> counter = Counter{};
+    const int built = copies;
+
+    // WHEN the chains are copied and composed
+    ExecutionChain<int> copy = first;
+    ExecutionChain<int> composed = first | second | counter;
+    composed |= Add{ 1000 };
+
+    // THEN the immutable blocks are shared instead of being copied
+    EXPECT_EQ(built + 1, copies);
+
+    int x = 0;
+    composed(x);
+    EXPECT_EQ(1112, x);
+
+    // AND appending to the composed chain does not modify the sub-chains
+    x = 0;
+    copy(x);
+    EXPECT_EQ(11, x);
+    x = 0;
+    first(x);
+    EXPECT_EQ(11, x);
+
+    // AND the stateful block was copied : its state is not shared
+    x = 0;
+    composed(x);
+    EXPECT_EQ(1113, x);
+    x = 0;
+    counter(x);
+    EXPECT_EQ(1, x);
+}
+
+TEST(ExecutionChainTest, CopiesOnlyShareTheShareableActions) {
+    struct Remember {
+        void operator()(int& a) const {
+            if (!first) {
+                first = a;
+            }
+            a = *first;
+        }
+        mutable std::optional<int> first;
+    };
+    auto steps = start_chain
+        | [](int& a) { ++a; }
+        | If([](int& a) { return a > 0; }).Then([](int& a) { ++a; });
+    static_assert(!is_shareable_v<Remember>);
+    static_assert(is_shareable_v<decltype(steps)>);
+
+    // GIVEN a chain of an action callable as const holding a mutable state, and a chain of stateless steps
+    ExecutionChain<int> remember = Remember{};
+    ExecutionChain<int> stateless = steps;
+
+    // WHEN the chains are copied
+    ExecutionChain<int> rememberCopy = remember;
+    const ExecutionChain<int> statelessCopy = stateless;
+
+    // THEN the stateful action is copied : each copy remembers its own first value
+    int x = 1;
+    remember(x);
+    x = 2;
+    rememberCopy(x);
+    EXPECT_EQ(2, x);
+    x = 3;
+    remember(x);
+    EXPECT_EQ(1, x);
+    EXPECT_FALSE(remember.memory_usage().blocks[0].shared);
+
+    // AND the stateless steps are shared
+    EXPECT_TRUE(stateless.memory_usage().blocks[0].shared);
+    x = 0;
+    statelessCopy(x);
+    EXPECT_EQ(2, x);
+}
+
+TEST(ExecutionChainTest, CompositionMovesActions) {
+    // a local class cannot refer to a local variable : the counter is static, reset at each run
+    static int copies;
+    copies = 0;
+    struct Add {
+        Add(int v) : value(v) {}
+        Add(const Add& other) : value(other.value) { ++copies; }
+        Add(Add&&) = default;
+        void operator()(int& a) { a += value; }
+        int value;
+    };
+
+    // GIVEN rvalue actions, block tuples and chains
+    ExecutionChain<int> chain = start_chain | Add{ 1 } | Add{ 10 };
+    chain |= start_chain | Add{ 100 };
+    ExecutionChain<int> composed = std::move(chain) | ExecutionChain<int>(Add{ 1000 });
+
+    // THEN building and composing them never copies an action
+    EXPECT_EQ(0, copies);
+    int x = 0;
+    composed(x);
+    EXPECT_EQ(1111, x);
+
+    // AND lvalues are still copied
+    auto handler = start_chain | Add{ 1 };
+    ExecutionChain<int> copy = handler | handler;
+    EXPECT_EQ(2, copies);
+    x = 0;
+    copy(x);
+    EXPECT_EQ(2, x);
+}
+
+TEST(ExecutionChainTest, MoveOnlyActions) {
+    struct Table {
+        using shareable = std::true_type;
+        void operator()(int& a) const { a += *value; }
+        std::unique_ptr<int> value;
+    };
+    struct Counter {
+        void operator()(int& a) { a += ++*count; }
+        std::unique_ptr<int> count;
+    };
+
+    // GIVEN a chain holding move-only actions
+    ExecutionChain<int> chain = start_chain | Table{ std::make_unique<int>(10) };
+    chain |= Table{ std::make_unique<int>(100) };
+    int x = 0;
+    chain(x);
+    EXPECT_EQ(110, x);
+
+    // WHEN the chain is copied, THEN its immutable blocks are shared
+    ExecutionChain<int> copy = chain;
+    x = 0;
+    copy(x);
+    EXPECT_EQ(110, x);
+
+    // AND a stateful move-only block can be moved but not copied
+    ExecutionChain<int> stateful = Counter{ std::make_unique<int>(0) };
+    ExecutionChain<int> moved = std::move(stateful);
+    x = 0;
+    moved(x);
+    EXPECT_EQ(1, x);
+    EXPECT_THROW(ExecutionChain<int>{ moved }, bad_block_copy);
+}
+
+TEST(ExecutionChainTest, AllocatesFromTheMemoryResource) {
+    struct Add {
+        void operator()(int& a) const { a += value; }
+        int value;
+    };
+    struct Counter {
+        void operator()(int& a) { a += ++count; }
+        int count = 0;
+    };
+
+    // GIVEN a sub-chain allocated from the default resource
+    ExecutionChain<int> sub = start_chain | Add{ 10 } | Counter{};
+
+    // WHEN a chain is built in a monotonic arena while the default resource can not allocate
+    std::array<std::byte, 16384> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    struct DefaultResourceGuard {
+        ~DefaultResourceGuard() { std::pmr::set_default_resource(previous); }
+        std::pmr::memory_resource* previous;
+    } guard{ std::pmr::set_default_resource(std::pmr::null_memory_resource()) };
+    int x = 0;
+    {
+        ExecutionChain<int> chain(&arena);
+        chain |= Add{ 1 };
+        chain |= Counter{};
+        chain.append(sub);
+        chain(x);
+
+        // THEN every block is allocated from the arena, a chain of another resource being copied
+        EXPECT_EQ(&arena, chain.resource());
+        ExecutionChain<int> copy(chain, &arena);
+        copy(x);
+    }
+    std::pmr::set_default_resource(guard.previous);
+
+    EXPECT_EQ(28, x);
+    x = 0;
+    sub(x);
+    EXPECT_EQ(11, x);
+}
+
+TEST(ExecutionChainTest, FreezeChain) {
+    struct Counter {
+        void operator()(int& a) { a += ++count; }
+        int count = 0;
+    };
+
+    // GIVEN a chain made of lambdas, functors and a BlockTuple with a logic flow
+    ExecutionChain<int> chain = start_chain | [](int& a) { a *= 2; } | Counter{};
+    chain |= start_chain
+        | If([](const int a) { return a > 5; }).Then([](int& a) { a -= 5; })
+        | [](int& a) { a *= 10; };
+
+    // WHEN the chain is frozen
+    const FrozenChain<int> frozen = chain.freeze();
+    // each BlockTuple is executed by a single instruction
+    EXPECT_EQ(2u, frozen.size());
+
+    // THEN the frozen chain executes the same actions in the same order
+    int x = 3;
+    frozen(x); // 3*2 = 6, +1 = 7, -5 = 2, *10 = 20
+    EXPECT_EQ(20, x);
+
+    // AND its blocks are independent from the ones of the chain
+    chain = {};
+    x = 3;
+    frozen(x); // 6, +2 = 8, -5 = 3, *10
+    EXPECT_EQ(30, x);
+
+    // AND it can be copied and moved
+    FrozenChain<int> copy = frozen;
+    FrozenChain<int> moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    x = 3;
+    moved(x); // 6, +3 = 9, -5 = 4, *10
+    EXPECT_EQ(40, x);
+
+    // AND an empty chain freezes into an empty program
+    EXPECT_TRUE(chain.freeze().empty());
+}
+
+TEST(ExecutionChainTest, ExecuteBatchRunsBlockByBlock) {
+    // GIVEN a chain recording the order in which its blocks are executed
+    std::vector<std::string> trace;
+    ExecutionChain<int&> chain;
+    chain |= [&](int& a) { trace.push_back("A" + std::to_string(a)); a += 1; };
+    chain |= [&](int& a) { trace.push_back("B" + std::to_string(a)); a *= 10; };
+
+    // WHEN executed over a batch of contexts
+    std::vector<int> values{ 1, 2, 3 };
+    chain.ExecuteBatch(values);
+
+    // THEN each block runs on the whole batch before the next one
+    EXPECT_EQ((std::vector<std::string>{ "A1", "A2", "A3", "B2", "B3", "B4" }), trace);
+    EXPECT_EQ((std::vector<int>{ 20, 30, 40 }), values);
+}
+
+TEST(ExecutionChainTest, ExecuteBatchUsesBatchOverloads) {
+    struct Scale {
+        void operator()(int& a) const { a *= factor; ++elementCalls; }
+        void operator()(std::span<int> batch) const {
+            ++batchCalls;
+            for (int& a : batch) {
+                a *= factor;
+            }
+        }
+        int factor;
+        int& elementCalls;
+        int& batchCalls;
+    };
+
+    int elementCalls = 0;
+    int batchCalls = 0;
+    ExecutionChain<int> chain = start_chain
+        | Scale{ 2, elementCalls, batchCalls }
+        | If([](const int a) { return a > 4; }).Then([](int& a) { a = 0; })
+        | [](int& a) { a += 1; };
+    chain |= Scale{ 3, elementCalls, batchCalls };
+
+    std::vector<int> values{ 1, 2, 3 };
+    chain.ExecuteBatch(values);
+
+    // THEN the actions providing a batch overload receive the whole span
+    EXPECT_EQ(2, batchCalls);
+    EXPECT_EQ(0, elementCalls);
+    EXPECT_EQ((std::vector<int>{ 9, 15, 3 }), values);
+
+    // AND Execute still calls the per element overload
+    int x = 1;
+    chain(x);
+    EXPECT_EQ(9, x);
+    EXPECT_EQ(2, elementCalls);
+}
+
+TEST(ExecutionChainTest, ExecuteBatchZipsArguments) {
+    ExecutionChain<int&, std::string&> chain = start_chain
+        | [](int& count, std::string& text) { text = std::string(count, '*'); }
+        | [](int& count, std::string&) { count = -count; };
+
+    std::vector<int> counts{ 1, 2, 3 };
+    std::vector<std::string> texts(3);
+    chain.ExecuteBatch(counts, texts);
+
+    EXPECT_EQ((std::vector<std::string>{ "*", "**", "***" }), texts);
+    EXPECT_EQ((std::vector<int>{ -1, -2, -3 }), counts);
+
+    // AND a BlockTuple can be executed over a batch as well
+    auto blockTuple = start_chain | [](int& count, std::string& text) { text += std::to_string(count); };
+    blockTuple.ExecuteBatch(std::span<int>(counts), std::span<std::string>(texts));
+    EXPECT_EQ((std::vector<std::string>{ "*-1", "**-2", "***-3" }), texts);
+}
+
+TEST(ExecutionChainTest, BatchedIfSelectsTheLanesOfEachBranch) {
+    // GIVEN the columns of a structure of arrays, and a chain branching on them
+    struct Pods {
+        std::vector<float> speed;
+        std::vector<int> gear;
+    };
+    Pods pods{ { 1.f, 5.f, 2.f, 8.f, 3.f }, std::vector<int>(5, 0) };
+    std::vector<std::string> trace;
+    ExecutionChain<float&, int&> chain = start_chain
+        | If([&](const float speed, const int&) { trace.push_back("?"); return speed > 2.5f; })
+            .Then([&](float&, int& gear) { trace.push_back("T"); gear = 2; })
+            .Else([&](float&, int& gear) { trace.push_back("E"); gear = 1; });
+
+    // WHEN executed over the columns
+    chain.ExecuteBatch(pods.speed, pods.gear);
+
+    // THEN the predicate is evaluated on every lane before the branches run on the lanes they selected
+    EXPECT_EQ((std::vector<std::string>{ "?", "?", "?", "?", "?", "T", "T", "T", "E", "E" }), trace);
+    EXPECT_EQ((std::vector<int>{ 1, 2, 1, 2, 2 }), pods.gear);
+}
+
+TEST(ExecutionChainTest, BatchedIfUsesTheBatchOverloadsOfItsPredicateAndBranch) {
+    // GIVEN a predicate writing its mask, and a branch receiving the selected lanes
+    struct IsOdd {
+        bool operator()(const int a) const { return a % 2 != 0; }
+        void operator()(std::span<int> batch, std::span<std::uint8_t> mask) const {
+            ++maskCalls;
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                mask[i] = static_cast<std::uint8_t>(batch[i] & 1);
+            }
+        }
+        int& maskCalls;
+    };
+    struct Negate {
+        void operator()(int& a) const { a = -a; }
+        void operator()(std::span<int> batch, std::span<const std::uint32_t> lanes) const {
+            ++laneCalls;
+            for (const std::uint32_t lane : lanes) {
+                batch[lane] = -batch[lane];
+            }
+        }
+        int& laneCalls;
+    };
+
+    int maskCalls = 0;
+    int laneCalls = 0;
+    ExecutionChain<int&> chain = start_chain | If(IsOdd{ maskCalls }).Then(Negate{ laneCalls });
+
+    // WHEN executed over more contexts than a chunk holds
+    std::vector<int> values(600);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<int>(i);
+    }
+    chain.ExecuteBatch(values);
+
+    // THEN both overloads are called once per chunk
+    EXPECT_EQ(3, maskCalls);
+    EXPECT_EQ(3, laneCalls);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(i % 2 != 0 ? -static_cast<int>(i) : static_cast<int>(i), values[i]);
+    }
+
+    // AND Execute still tests each context
+    int x = 3;
+    chain(x);
+    EXPECT_EQ(-3, x);
+}
+
+TEST(ExecutionChainTest, BatchedIfAcceptsAnyNonzeroMaskByte) {
+    // GIVEN a batch predicate setting the selected lanes to 0xFF, as a simd mask does
+    struct IsPositive {
+        bool operator()(const int a) const { return a > 0; }
+        void operator()(std::span<int> batch, std::span<std::uint8_t> mask) const {
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                mask[i] = batch[i] > 0 ? 0xFF : 0x00;
+            }
+        }
+    };
+    int thenCalls = 0;
+    int elseCalls = 0;
+    ExecutionChain<int&> chain = start_chain
+        | If(IsPositive{}).Then([&](int& a) { ++thenCalls; a = 1; }).Else([&](int& a) { ++elseCalls; a = -1; });
+
+    // WHEN executed over full chunks of lanes
+    std::vector<int> values(512);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = i % 3 == 0 ? 0 : static_cast<int>(i);
+    }
+    chain.ExecuteBatch(values);
+
+    // THEN each lane runs a single branch
+    EXPECT_EQ(341, thenCalls);
+    EXPECT_EQ(171, elseCalls);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(i % 3 == 0 ? -1 : 1, values[i]);
+    }
+}
+
+TEST(ExecutionChainTest, ExecuteParallel) {
+    ThreadPool pool(4);
+
+    // GIVEN a chain of stateless actions
+    ExecutionChain<int&> chain = start_chain | [](int& a) { a += 1; } | [](int& a) { a *= 2; };
+    chain |= [](int& a) { a -= 1; };
+
+    // WHEN executed in parallel over a large batch
+    std::vector<int> values(10000);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<int>(i);
+    }
+    chain.ExecuteParallel(pool, 128, values);
+
+    // THEN every context went through the whole chain once
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(static_cast<int>(i + 1) * 2 - 1, values[i]);
+    }
+
+    // AND a BlockTuple provides the same entry point
+    const auto blockTuple = start_chain | [](int& a) { a = -a; };
+    blockTuple.ExecuteParallel(pool, std::span<int>(values));
+    EXPECT_EQ(-1, values[0]);
+    EXPECT_EQ(-19999, values.back());
+}
+
+TEST(ExecutionChainTest, ShortCircuitChainStopsAtTheFirstFailure) {
+    std::vector<std::string> trace;
+
+    // GIVEN a short-circuit chain mixing void and bool blocks
+    ShortCircuitChain<int&> chain;
+    chain |= [&](int&) { trace.push_back("void"); };
+    chain |= Try([&](int& a) { trace.push_back("try"); return a > 0; })
+                .Fallback([&](int&) { trace.push_back("fallback"); return false; });
+    chain |= [&](int&) { trace.push_back("last"); };
+
+    // WHEN a bool block succeeds
+    int x = 1;
+    // THEN the chain runs to the end
+    EXPECT_TRUE(chain(x));
+    EXPECT_EQ((std::vector<std::string>{ "void", "try", "last" }), trace);
+
+    // WHEN a bool block fails
+    trace.clear();
+    x = 0;
+    // THEN the remaining blocks are skipped
+    EXPECT_FALSE(chain(x));
+    EXPECT_EQ((std::vector<std::string>{ "void", "try", "fallback" }), trace);
+
+    // AND the frozen chain keeps the short-circuit behavior
+    trace.clear();
+    EXPECT_FALSE(chain.freeze()(x));
+    EXPECT_EQ((std::vector<std::string>{ "void", "try", "fallback" }), trace);
+}
+
+TEST(ExecutionChainTest, RunToEndChainIgnoresFailures) {
+    int calls = 0;
+    ExecutionChain<int> chain = start_chain | [&](int&) { ++calls; return false; } | [&](int&) { ++calls; };
+
+    EXPECT_TRUE(chain(0));
+    EXPECT_EQ(2, calls);
+}
+
+TEST(ExecutionChainTest, BlockTupleShortCircuit) {
+    int calls = 0;
+    auto blockTuple = start_chain
+        | [&](int&) { ++calls; }
+        | If([](const int a) { return a > 0; }).Then([&](int&) { ++calls; return true; }).Else([](int&) { return false; })
+        | [&](int&) { ++calls; };
+
+    // WHEN executed with the default policy, every action runs
+    int x = 0;
+    EXPECT_TRUE(blockTuple(x));
+    EXPECT_EQ(2, calls);
+
+    // WHEN executed with the ShortCircuit policy, the execution stops at the failing action
+    calls = 0;
+    EXPECT_FALSE(blockTuple.Execute<ExecutionPolicy::ShortCircuit>(x));
+    EXPECT_EQ(1, calls);
+
+    x = 1;
+    calls = 0;
+    EXPECT_TRUE(blockTuple.Execute<ExecutionPolicy::ShortCircuit>(x));
+    EXPECT_EQ(3, calls);
+
+    // AND a BlockTuple stored in a ShortCircuitChain short-circuits as well
+    ShortCircuitChain<int> chain = blockTuple;
+    chain |= [&](int&) { calls = 100; };
+    calls = 0;
+    EXPECT_FALSE(chain(0));
+    EXPECT_EQ(1, calls);
+}
+
+TEST(ExecutionChainTest, AllJoinsItsBranches) {
+    ThreadPool pool(2);
+
+    // GIVEN a chain forking 3 branches writing independent fields
+    struct Race { int my = 0; int other = 0; int total = 0; bool ready = true; };
+    ShortCircuitChain<Race&> chain = start_chain
+        | All([](Race& r) { r.my = 1; },
+              [](Race& r) { r.other = 2; },
+              [](const Race& r) { return r.ready; }).On(pool)
+        | [](Race& r) { r.total = r.my + r.other; };
+
+    // WHEN every branch succeeds
+    Race race;
+    // THEN the chain continues once they are all done
+    EXPECT_TRUE(chain(race));
+    EXPECT_EQ(3, race.total);
+
+    // WHEN a branch fails
+    Race notReady;
+    notReady.ready = false;
+    // THEN all the branches ran, and the step fails
+    EXPECT_FALSE(chain(notReady));
+    EXPECT_EQ(1, notReady.my);
+    EXPECT_EQ(2, notReady.other);
+    EXPECT_EQ(0, notReady.total);
+
+    // AND an exception thrown by a branch is rethrown by the step
+    auto throwing = All([](int&) {}, [](int&) { throw std::runtime_error("branch"); }).On(pool);
+    int x = 0;
+    EXPECT_THROW(throwing(x), std::runtime_error);
+
+    // AND a step with a stateful branch is stored as a stateful block
+    int calls = 0;
+    ExecutionChain<int&> stateful = All([calls](int&) mutable { ++calls; }, [](int& a) { ++a; }).On(pool);
+    stateful(x);
+    EXPECT_EQ(1, x);
+}
+
+TEST(ExecutionChainTest, AnyStopsAtTheFirstSuccess) {
+    ThreadPool pool(2);
+
+    // GIVEN an Any step whose first branch succeeds, and whose second one waits for the cancellation
+    std::atomic<int> calls = 0;
+    auto any = Any([&](int&) { ++calls; return true; },
+                   [&](int&, std::stop_token token) {
+                       ++calls;
+                       while (!token.stop_requested()) { std::this_thread::yield(); }
+                       return false;
+                   }).On(pool);
+
+    // WHEN executed
+    int x = 0;
+    // THEN the success cancels the running branch
+    EXPECT_TRUE(any(x));
+    EXPECT_LE(calls.load(), 2);
+
+    // GIVEN an Any step whose branches all fail
+    calls = 0;
+    auto none = Any([&](int&) { ++calls; return false; }, [&](int&) { ++calls; return false; }).On(pool);
+    // THEN every branch runs, and the step fails
+    EXPECT_FALSE(none(x));
+    EXPECT_EQ(2, calls.load());
+
+    // AND an Any step can be stored in a chain
+    ShortCircuitChain<int&> chain = start_chain
+        | Any([](const int& a) { return a > 0; }, [](const int& a) { return a < -10; })
+        | [](int& a) { a = 100; };
+    int positive = 1;
+    int negative = -1;
+    EXPECT_TRUE(chain(positive));
+    EXPECT_FALSE(chain(negative));
+    EXPECT_EQ(100, positive);
+    EXPECT_EQ(-1, negative);
+}
+
+TEST(ExecutionChainTest, SwitchExecutesTheMatchingCase) {
+    enum class Type { Order, Cancel, Heartbeat, Replace, Status };
+    struct Message { Type type; std::string trace; };
+
+    auto route = [](std::string name) { return [name](Message& m) { m.trace += name; }; };
+
+    // GIVEN a dense Switch (jump table) with a Default
+    ExecutionChain<Message&> dense = start_chain
+        | Switch([](const Message& m) { return m.type; })
+              .Case<Type::Order>(route("order"))
+              .Case<Type::Cancel>(route("cancel"))
+              .Case<Type::Replace>(route("replace"))
+              .Case<Type::Status>(route("status"))
+              .Default(route("default"));
+
+    // WHEN executed with each type
+    // THEN the matching case, or the Default, is executed
+    for (auto [type, expected] : { std::pair{ Type::Order, "order" }, { Type::Cancel, "cancel" },
+                                   { Type::Heartbeat, "default" }, { Type::Status, "status" } }) {
+        Message message{ type, "" };
+        dense(message);
+        EXPECT_EQ(expected, message.trace);
+    }
+
+    // GIVEN a sparse Switch on an int without Default, the case results being forwarded
+    ShortCircuitChain<int&> sparse = start_chain
+        | Switch([](const int& a) { return a; })
+              .Case<-1000>([](int& a) { a = 1; })
+              .Case<7>([](int&) { return false; })
+              .Case<1000000>([](int& a) { a = 3; })
+        | [](int& a) { a *= 10; };
+
+    int x = 1000000;
+    EXPECT_TRUE(sparse(x));
+    EXPECT_EQ(30, x);
+    x = -1000;
+    EXPECT_TRUE(sparse(x));
+    EXPECT_EQ(10, x);
+    // a case returning false short-circuits the chain
+    x = 7;
+    EXPECT_FALSE(sparse(x));
+    EXPECT_EQ(7, x);
+    // no case matches : nothing is executed, the chain continues
+    x = 5;
+    EXPECT_TRUE(sparse(x));
+    EXPECT_EQ(50, x);
+}
+
+TEST(ExecutionChainTest, MatchDispatchesOnTheAlternative) {
+    struct Order { int quantity; };
+    struct Cancel { int id; };
+    struct Heartbeat {};
+    using Message = std::variant<Order, Cancel, Heartbeat>;
+
+    // GIVEN a Match with an action for Order and Cancel, and a stateful counter
+    int total = 0;
+    int cancelled = 0;
+    ExecutionChain<Message&, int&> chain = start_chain
+        | Match([](Order& o, int& t) { t += o.quantity; },
+                [&cancelled](Cancel& c, int&) mutable { cancelled = c.id; });
+
+    // WHEN executed with each alternative
+    std::vector<Message> messages{ Order{ 3 }, Cancel{ 42 }, Heartbeat{}, Order{ 4 } };
+    for (auto& message : messages) {
+        chain(message, total);
+    }
+
+    // THEN each alternative went to its action, Heartbeat being ignored
+    EXPECT_EQ(7, total);
+    EXPECT_EQ(42, cancelled);
+}
+
+TEST(ExecutionChainTest, FirstOfExecutesTheFirstMatchingCase) {
+    // GIVEN a FirstOf with 3 cases, in a short-circuit chain
+    std::vector<std::string> trace;
+    auto is = [](int k) { return [k](const int& a) { return a == k; }; };
+    ShortCircuitChain<int&> chain = start_chain
+        | FirstOf(If(is(1)).Then([&](int&) { trace.push_back("one"); }),
+                  If(is(2)).Then([&](int&) { trace.push_back("two"); return false; }),
+                  If(is(3)).Then([&](int&) { trace.push_back("three"); }))
+        | [&](int&) { trace.push_back("next"); };
+
+    // WHEN a predicate holds, THEN only its branch is executed, and its result is forwarded
+    int x = 3;
+    EXPECT_TRUE(chain(x));
+    x = 2;
+    EXPECT_FALSE(chain(x));
+    // WHEN no predicate holds, THEN the chain continues
+    x = 0;
+    EXPECT_TRUE(chain(x));
+    EXPECT_EQ((std::vector<std::string>{ "three", "next", "two", "next" }), trace);
+}
+
+TEST(ExecutionChainTest, FirstOfMovesItsCases) {
+    // GIVEN cases holding a move-only state, and a case counting its copies
+    static int copies;
+    copies = 0;
+    struct Counted {
+        Counted() = default;
+        Counted(const Counted&) { ++copies; }
+        Counted(Counted&&) noexcept = default;
+        void operator()(int& a) const { a += 10; }
+    };
+    auto owned = std::make_unique<int>(100);
+    auto addOwned = [value = std::move(owned)](int& a) { a += *value; };
+
+    // WHEN they are composed into a chain through an adaptive FirstOf
+    ExecutionChain<int&> chain = start_chain
+        | FirstOf(If([](const int& a) { return a > 0; }).Then(std::move(addOwned)),
+                  If([](const int& a) { return a < 0; }).Then(Counted{}))
+              .Adaptive();
+
+    // THEN no case was copied, and the move-only case is executed
+    EXPECT_EQ(0, copies);
+    int x = 1;
+    chain(x);
+    EXPECT_EQ(101, x);
+    x = -1;
+    chain(x);
+    EXPECT_EQ(9, x);
+}
+
+TEST(ExecutionChainTest, AdaptiveFirstOfReordersByFrequency) {
+    // GIVEN an adaptive FirstOf sampling every execution, reordering every 8 samples
+    std::atomic<int> calls = 0;
+    auto is = [](int k) { return [k](const int& a) { return a == k; }; };
+    auto count = [&](int&) { ++calls; };
+    auto firstOf = FirstOf(If(is(0)).Then(count), If(is(1)).Then(count), If(is(2)).Then(count)).Adaptive(1, 8);
+    EXPECT_EQ((std::array<std::size_t, 3>{ 0, 1, 2 }), firstOf.Order());
+
+    // WHEN the last case is the most frequent
+    for (int i = 0; i < 16; ++i) {
+        int x = i % 4 == 0 ? 1 : 2;
+        firstOf(x);
+    }
+
+    // THEN it is evaluated first, then the second one
+    EXPECT_EQ((std::array<std::size_t, 3>{ 2, 1, 0 }), firstOf.Order());
+    EXPECT_EQ(16, calls.load());
+
+    // WHEN the mix changes, THEN the order follows
+    for (int i = 0; i < 64; ++i) {
+        int x = 0;
+        firstOf(x);
+    }
+    EXPECT_EQ(0u, firstOf.Order()[0]);
+
+    // AND executing from several threads while reordering runs each case once
+    calls = 0;
+    ExecutionChain<int&> shared = std::move(firstOf);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared, t] {
+            for (int i = 0; i < 1000; ++i) {
+                int x = (i + t) % 3;
+                shared(x);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(4000, calls.load());
+}
+
+namespace {
+
+// Fields of the context of the incremental tests
+enum RaceField : FieldMask { Input = 1 << 0, Speed = 1 << 1, Position = 1 << 2, Score = 1 << 3 };
+
+struct Race {
+    int input = 0;
+    int speed = 0;
+    int position = 0;
+    int score = 0;
+    std::vector<std::string> trace{};
+};
+
+struct Accelerate {
+    static constexpr FieldMask reads = Input;
+    static constexpr FieldMask writes = Speed;
+    void operator()(Race& r) const { r.speed = r.input * 2; r.trace.push_back("accelerate"); }
+};
+
+} // namespace
+
+TEST(ExecutionChainTest, ExecuteIncrementalSkipsTheCleanBlocks) {
+    // GIVEN a chain whose blocks declare the fields they read and write
+    ExecutionChain<Race&> chain = start_chain
+        | Accelerate{}
+        | Access<Speed, Position>([](Race& r) { r.position = r.speed; r.trace.push_back("move"); });
+    chain |= Access<Score, Score>([](Race& r) { ++r.score; r.trace.push_back("score"); });
+    chain |= [](Race& r) { r.trace.push_back("undeclared"); };
+
+    // WHEN executed for the first time, THEN every block runs
+    Race race{ .input = 1 };
+    FieldMask dirty = AllFields;
+    EXPECT_TRUE(chain.ExecuteIncremental(dirty, race));
+    EXPECT_EQ((std::vector<std::string>{ "accelerate", "move", "score", "undeclared" }), race.trace);
+    EXPECT_EQ(2, race.position);
+    // AND the score, read and written by the same block, is dirty for the next execution
+    EXPECT_EQ(Score, dirty & Score);
+
+    // WHEN nothing changed but the score, THEN only the blocks reading it run
+    race.trace.clear();
+    dirty = Score;
+    chain.ExecuteIncremental(dirty, race);
+    EXPECT_EQ((std::vector<std::string>{ "score", "undeclared" }), race.trace);
+
+    // WHEN the input changes, THEN the downstream blocks of its writes run
+    race.trace.clear();
+    race.input = 3;
+    dirty = Input;
+    chain.ExecuteIncremental(dirty, race);
+    EXPECT_EQ((std::vector<std::string>{ "accelerate", "move", "undeclared" }), race.trace);
+    EXPECT_EQ(6, race.position);
+}
+
+TEST(ExecutionChainTest, ExecuteIncrementalAlwaysRunsTheUndeclaredBlocks) {
+    // GIVEN a chain of declared blocks followed by a block which does not declare its fields
+    ExecutionChain<Race&> chain = start_chain
+        | Accelerate{}
+        | Access<Speed, Position>([](Race& r) { r.position = r.speed; r.trace.push_back("move"); });
+    chain |= [](Race& r) { r.trace.push_back("log"); };
+
+    // WHEN executed for the first time, THEN the undeclared block does not make the next execution run everything
+    Race race{ .input = 1 };
+    FieldMask dirty = AllFields;
+    chain.ExecuteIncremental(dirty, race);
+    EXPECT_EQ(NoFields, dirty);
+
+    // WHEN nothing changed, THEN only the undeclared block runs
+    race.trace.clear();
+    chain.ExecuteIncremental(dirty, race);
+    EXPECT_EQ((std::vector<std::string>{ "log" }), race.trace);
+    EXPECT_EQ(NoFields, dirty);
+
+    // GIVEN an undeclared block before declared ones, in a chain and in a BlockTuple
+    ExecutionChain<Race&> first = start_chain
+        | [](Race& r) { r.trace.push_back("log"); }
+        | Access<Score, Score>([](Race& r) { r.trace.push_back("score"); });
+    auto blockTuple = start_chain
+        | [](Race& r) { r.trace.push_back("log"); }
+        | Access<Score, NoFields>([](Race& r) { r.trace.push_back("score"); });
+
+    // WHEN nothing changed, THEN the undeclared block runs, and the blocks after it see every field as dirty
+    race.trace.clear();
+    dirty = NoFields;
+    first.ExecuteIncremental(dirty, race);
+    EXPECT_EQ((std::vector<std::string>{ "log", "score" }), race.trace);
+    EXPECT_EQ(Score, dirty);
+    race.trace.clear();
+    dirty = NoFields;
+    blockTuple.ExecuteIncremental(dirty, race);
+    EXPECT_EQ((std::vector<std::string>{ "log", "score" }), race.trace);
+    EXPECT_EQ(NoFields, dirty);
+}
+
+TEST(ExecutionChainTest, BlockTupleExecuteIncremental) {
+    // GIVEN a BlockTuple of declared actions
+    auto blockTuple = start_chain
+        | Accelerate{}
+        | Access<Speed, Position>([](Race& r) { r.position = r.speed; r.trace.push_back("move"); })
+        | Access<Position, NoFields>([](Race& r) { r.trace.push_back("render"); return false; });
+    static_assert(decltype(blockTuple)::reads == (Input | Speed | Position));
+    static_assert(decltype(blockTuple)::writes == (Speed | Position));
+
+    // WHEN only the position changed, THEN only the last action runs
+    Race race;
+    FieldMask dirty = Position;
+    EXPECT_TRUE(blockTuple.ExecuteIncremental(dirty, race));
+    EXPECT_EQ((std::vector<std::string>{ "render" }), race.trace);
+    EXPECT_EQ(NoFields, dirty);
+
+    // WHEN stored in a ShortCircuit chain, THEN its actions are still checked one by one
+    ShortCircuitChain<Race&> chain = blockTuple;
+    chain |= Access<Position, NoFields>([](Race& r) { r.trace.push_back("unreached"); });
+    race.trace.clear();
+    dirty = Speed;
+    EXPECT_FALSE(chain.ExecuteIncremental(dirty, race));
+    EXPECT_EQ((std::vector<std::string>{ "move", "render" }), race.trace);
+    // AND the dirty fields are kept for the blocks which were not reached
+    EXPECT_EQ(Speed | Position, dirty);
+}
+
+TEST(ExecutionChainTest, ConstantPredicatesAreFolded) {
+    // GIVEN If steps whose predicates are known at compile time
+    constexpr bool featureEnabled = false;
+    auto blockTuple = start_chain
+        | [](int& a) { a += 1; }
+        | If(std::true_type{}).Then([](int& a) { a *= 10; }).Else([](int& a) { a = -1; })
+        | If(std::bool_constant<featureEnabled>{}).Then([](int& a) { a = -2; })
+        | NoOp{}
+        | If(std::false_type{}).Then([](int&) {}).Else(start_chain | [](int& a) { a += 2; } | [](int& a) { a *= 3; });
+
+    // THEN the steps are replaced by their selected branch, the disabled ones and the NoOp are dropped,
+    // and the BlockTuple of the Else branch is flattened
+    static_assert(decltype(blockTuple)::size() == 4);
+    int x = 0;
+    blockTuple(x);
+    EXPECT_EQ(36, x);
+
+    // AND an ExecutionChain drops them as well
+    ExecutionChain<int&> chain;
+    chain |= NoOp{};
+    chain |= If(std::false_type{}).Then([](int& a) { a = -2; });
+    chain |= If(std::true_type{}).Then([](int& a) { ++a; });
+    EXPECT_EQ(1u, chain.freeze().size());
+    chain(x);
+    EXPECT_EQ(37, x);
+
+    // AND a constant predicate is still a valid step when executed as such
+    const auto step = If(std::false_type{}).Then([](int& a) { a = 0; }).Else([](int& a) { a = 5; });
+    step(x);
+    EXPECT_EQ(5, x);
+}
+
+TEST(ExecutionChainTest, RepeatExecutesTheActionSeveralTimes) {
+    // GIVEN an unrolled, a large and a run time repetition
+    ExecutionChain<int&> chain = start_chain
+        | Repeat<3>([](int& a) { a += 1; })
+        | Repeat<20>([](int& a) { a += 10; })
+        | Repeat(std::size_t{ 2 }, [](int& a) { a *= 2; });
+
+    int x = 0;
+    EXPECT_TRUE(chain(x));
+    EXPECT_EQ((3 + 200) * 4, x);
+
+    // WHEN the action returns false, THEN the repetitions stop and the step fails
+    int calls = 0;
+    auto limited = Repeat<5>([&calls](int& a) { ++calls; return ++a < 2; });
+    x = 0;
+    EXPECT_FALSE(limited(x));
+    EXPECT_EQ(2, calls);
+
+    auto runtime = Repeat(5, [&calls](int&) { ++calls; return calls < 4; });
+    EXPECT_FALSE(runtime(x));
+    EXPECT_EQ(4, calls);
+}
+
+TEST(ExecutionChainTest, RepeatRunsEachRepetitionOverTheBatch) {
+    // GIVEN an action with a batch overload
+    struct Increment {
+        void operator()(int& a) const { ++a; }
+        void operator()(std::span<int> batch) const { ++(*batchCalls); for (int& a : batch) { ++a; } }
+        int* batchCalls;
+    };
+    int batchCalls = 0;
+    ExecutionChain<int&> chain = start_chain | Repeat<3>(Increment{ &batchCalls });
+
+    std::vector<int> values(8, 0);
+    chain.ExecuteBatch(values);
+
+    // THEN each repetition used the batch overload
+    EXPECT_EQ(3, batchCalls);
+    EXPECT_EQ(std::vector<int>(8, 3), values);
+}
+
+TEST(ExecutionChainTest, WhileDoLoopsAsLongAsThePredicateHolds) {
+    ShortCircuitChain<int&> chain = start_chain
+        | While([](const int& a) { return a < 10; }).Do([](int& a) { a += 3; })
+        | [](int& a) { a = -a; };
+
+    int x = 0;
+    EXPECT_TRUE(chain(x));
+    EXPECT_EQ(-12, x);
+
+    // WHEN the action fails, THEN the loop and the chain stop
+    auto failing = While([](const int&) { return true; }).Do([](int& a) { return ++a < 5; });
+    x = 0;
+    EXPECT_FALSE(failing(x));
+    EXPECT_EQ(5, x);
+}
+
+} // namespace chain
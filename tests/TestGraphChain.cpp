@@ -0,0 +1,102 @@
+#include "../execution_chain/GraphChain.h"
+#include <gtest/gtest.h>
+#include <latch>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+struct Race {
+    int pods = 1;
+    int myCollisions = 0;
+    int otherCollisions = 0;
+    int thrust = 0;
+};
+
+enum RaceField : FieldMask {
+    Pods = 1 << 0,
+    MyCollisions = 1 << 1,
+    OtherCollisions = 1 << 2,
+    Thrust = 1 << 3,
+};
+
+} // namespace
+
+TEST(GraphChainTest, SchedulesTheBlocksByTheirFields) {
+    // GIVEN 2 blocks reading the pods and writing their own field, and a block reading both fields
+    ThreadPool pool(2);
+    GraphChain<Race&> graph(pool);
+    const auto mine = graph.Add(Access<Pods, MyCollisions>([](Race& r) { r.myCollisions = r.pods + 1; }));
+    const auto other = graph.Add(Access<Pods, OtherCollisions>([](Race& r) { r.otherCollisions = r.pods + 2; }));
+    const auto thrust = graph.Add(Access<MyCollisions | OtherCollisions, Thrust>(
+        [](Race& r) { r.thrust = r.myCollisions * r.otherCollisions; }));
+
+    // THEN the 2 first blocks are independent, the last one depends on both
+    EXPECT_TRUE(graph.Dependencies(mine).empty());
+    EXPECT_TRUE(graph.Dependencies(other).empty());
+    EXPECT_EQ((std::vector<std::size_t>{ mine, other }), graph.Dependencies(thrust));
+    EXPECT_EQ((std::vector<std::vector<std::size_t>>{ { mine, other }, { thrust } }), graph.Levels());
+    EXPECT_EQ(2u, graph.CriticalPath());
+
+    // WHEN executed, THEN the results are the ones of the sequential execution
+    Race race;
+    EXPECT_TRUE(graph(race));
+    EXPECT_EQ(6, race.thrust);
+
+    // AND a block without declared fields depends on every block before it
+    const auto log = graph.Add([](Race&) {});
+    EXPECT_EQ((std::vector<std::size_t>{ mine, other, thrust }), graph.Dependencies(log));
+    EXPECT_EQ(3u, graph.CriticalPath());
+}
+
+TEST(GraphChainTest, RunsTheIndependentBlocksConcurrently) {
+    // GIVEN 2 roots which can only finish when both are running, and a block depending on both
+    ThreadPool pool(2);
+    GraphChain<std::string&> graph(pool);
+    std::latch bothRunning(2);
+    std::mutex mutex;
+    std::vector<std::string> trace;
+    const auto record = [&](const char* name) {
+        std::lock_guard lock(mutex);
+        trace.push_back(name);
+    };
+    const auto a = graph.Add([&](std::string&) { bothRunning.arrive_and_wait(); record("a"); }, {});
+    const auto b = graph.Add([&](std::string&) { bothRunning.arrive_and_wait(); record("b"); }, {});
+    graph.Add([&](std::string&) { record("c"); }, { a, b });
+
+    // WHEN executed
+    std::string context;
+    EXPECT_TRUE(graph.Execute(context));
+
+    // THEN the roots ran at the same time, before their dependent block
+    ASSERT_EQ(3u, trace.size());
+    EXPECT_EQ("c", trace.back());
+}
+
+TEST(GraphChainTest, ShortCircuitStopsAfterTheFailedLevel) {
+    // GIVEN a failing root, an independent root, and a block depending on the failing one
+    ShortCircuitGraphChain<Race&> graph;
+    const auto fails = graph.Add([](Race& r) { r.myCollisions = 1; return false; }, {});
+    graph.Add([](Race& r) { r.otherCollisions = 1; }, {});
+    graph.Add([](Race& r) { r.thrust = 1; }, { fails });
+
+    // THEN the level of the failed block ran, but not the next one
+    Race race;
+    EXPECT_FALSE(graph(race));
+    EXPECT_EQ(1, race.myCollisions);
+    EXPECT_EQ(1, race.otherCollisions);
+    EXPECT_EQ(0, race.thrust);
+
+    // AND a RunToEnd graph executes every level
+    GraphChain<int&> runToEnd;
+    const auto first = runToEnd.Add([](int& y) { y += 1; return false; }, {});
+    runToEnd.Add([](int& y) { y += 100; }, { first });
+    int y = 0;
+    EXPECT_TRUE(runToEnd(y));
+    EXPECT_EQ(101, y);
+}
+
+} // namespace chain
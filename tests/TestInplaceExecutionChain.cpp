@@ -0,0 +1,114 @@
+#include "../execution_chain/InplaceExecutionChain.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace chain {
+
+TEST(InplaceExecutionChainTest, ExecutesActionsInOrder) {
+    int calls = 0;
+    InplaceExecutionChain<4, 64, int> chain = start_chain | [](int& a) { ++a; } | [](int& a) { a *= 4; };
+    chain |= [&calls](int& a) { a -= 1; ++calls; };
+
+    int x = 0;
+    EXPECT_TRUE(chain(x));
+    EXPECT_EQ(3, x);
+    EXPECT_EQ(1, calls);
+
+    // the block tuple is a single block
+    EXPECT_EQ(2u, chain.size());
+}
+
+TEST(InplaceExecutionChainTest, ShortCircuitStopsAtTheFirstFailure) {
+    // GIVEN chains whose second block fails
+    const auto fail = [](int& a) { a += 10; return false; };
+    InplaceShortCircuitChain<4, 64, int> shortCircuit = start_chain | [](int& a) { ++a; };
+    shortCircuit |= fail;
+    shortCircuit |= [](int& a) { a *= 100; };
+    InplaceExecutionChain<4, 64, int> runToEnd = start_chain | [](int& a) { ++a; };
+    runToEnd |= fail;
+    runToEnd |= [](int& a) { a *= 100; };
+
+    // WHEN executed, THEN the ShortCircuit chain stops and reports it, the other one runs to the end
+    int x = 0;
+    EXPECT_FALSE(shortCircuit(x));
+    EXPECT_EQ(11, x);
+    x = 0;
+    EXPECT_TRUE(runToEnd(x));
+    EXPECT_EQ(1100, x);
+
+    // AND a BlockTuple block short-circuits its own actions
+    InplaceShortCircuitChain<2, 64, int> blockTuple = start_chain | fail | [](int& a) { a *= 100; };
+    x = 0;
+    EXPECT_FALSE(blockTuple(x));
+    EXPECT_EQ(10, x);
+}
+
+TEST(InplaceExecutionChainTest, RejectsActionsBeyondTheCapacity) {
+    struct Add {
+        void operator()(int& a) const { a += value; }
+        int value;
+    };
+
+    // GIVEN a chain with room for two blocks only
+    InplaceExecutionChain<2, 64, int> chain;
+    EXPECT_TRUE(chain.try_append(Add{ 1 }));
+    EXPECT_TRUE(chain.try_append(Add{ 10 }));
+
+    // THEN no more block can be appended
+    EXPECT_FALSE(chain.try_append(Add{ 100 }));
+
+    // GIVEN a chain with room for two actions by size only
+    InplaceExecutionChain<8, 8, int> small;
+    EXPECT_TRUE(small.try_append(Add{ 1 }));
+    EXPECT_TRUE(small.try_append(Add{ 10 }));
+    EXPECT_FALSE(small.try_append(Add{ 100 }));
+
+    // AND the chains are unchanged by the rejected actions
+    int x = 0;
+    chain(x);
+    EXPECT_EQ(11, x);
+    x = 0;
+    small(x);
+    EXPECT_EQ(11, x);
+    EXPECT_EQ(8u, small.bytes());
+
+    // AND a cleared chain can be reused
+    small.clear();
+    EXPECT_TRUE(small.empty());
+    small = Add{ 5 };
+    x = 0;
+    small(x);
+    EXPECT_EQ(5, x);
+}
+
+TEST(InplaceExecutionChainTest, IsTriviallyCopyable) {
+    using Chain_t = InplaceExecutionChain<4, 64, int>;
+    static_assert(std::is_trivially_copyable_v<Chain_t>);
+
+    struct Counter {
+        void operator()(int& a) { a = ++count; }
+        int count;
+    };
+
+    // non trivial actions can not be stored
+    auto owning = [s = std::string{}](int&) {};
+    static_assert(!Chain_t::is_storable<decltype(owning)>::value);
+
+    // GIVEN a chain copied with memcpy
+    Chain_t chain = Counter{ 0 };
+    int x = 0;
+    chain(x);
+
+    Chain_t copy;
+    std::memcpy(static_cast<void*>(&copy), &chain, sizeof(Chain_t));
+
+    // THEN the copy owns its own state
+    copy(x);
+    EXPECT_EQ(2, x);
+    chain(x);
+    EXPECT_EQ(2, x);
+}
+
+} // namespace chain
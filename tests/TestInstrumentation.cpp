@@ -0,0 +1,108 @@
+// Built with EXECUTION_CHAIN_INSTRUMENTATION=1 (see the instrumentation_tests target)
+#include "../execution_chain/ExecutionChain.h"
+#include "../execution_chain/ExecutionFlow.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <typeinfo>
+
+namespace chain {
+
+namespace {
+
+struct Sleep {
+    void operator()(int&) const { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }
+};
+
+struct Increment {
+    void operator()(int& a) const { ++a; }
+};
+
+} // namespace
+
+TEST(InstrumentationTest, ReportsEachBlock) {
+    // GIVEN a chain of 3 blocks, the second one being slow
+    ExecutionChain<int&> chain;
+    chain |= Increment{};
+    chain |= Sleep{};
+    chain |= [](int& a) { a *= 2; };
+
+    // WHEN executed 3 times
+    int x = 0;
+    for (int i = 0; i < 3; ++i) {
+        chain(x);
+    }
+
+    // THEN each block reports its position, its type and its calls
+    const ChainReport report = chain.Report();
+    ASSERT_EQ(3u, report.blocks.size());
+    for (std::size_t i = 0; i < report.blocks.size(); ++i) {
+        EXPECT_EQ(i, report.blocks[i].index);
+        EXPECT_EQ(3u, report.blocks[i].calls);
+    }
+    EXPECT_EQ(typeid(Increment), *report.blocks[0].type);
+    EXPECT_EQ(typeid(Sleep), *report.blocks[1].type);
+
+    // AND the slow block is the slowest one
+    ASSERT_NE(nullptr, report.Slowest());
+    EXPECT_EQ(1u, report.Slowest()->index);
+    EXPECT_GE(report.blocks[1].total, std::chrono::milliseconds(6));
+    EXPECT_GE(report.blocks[1].Percentile(0.5), std::chrono::milliseconds(2));
+    EXPECT_GE(report.blocks[1].Percentile(1.0), report.blocks[1].Percentile(0.5));
+
+    // WHEN the report is reset
+    chain.ResetReport();
+    // THEN the statistics restart from zero
+    EXPECT_EQ(0u, chain.Report().blocks[1].calls);
+}
+
+TEST(InstrumentationTest, ReportsTheActionsOfABlockTuple) {
+    // GIVEN a BlockTuple stored as a single block
+    auto blockTuple = start_chain | Increment{} | Sleep{};
+    ExecutionChain<int&> chain = blockTuple;
+
+    int x = 0;
+    chain(x);
+    blockTuple(x);
+    blockTuple(x);
+
+    // THEN the block reports the statistics of each action
+    const ChainReport report = chain.Report();
+    ASSERT_EQ(1u, report.blocks.size());
+    EXPECT_EQ(1u, report.blocks[0].calls);
+    ASSERT_EQ(2u, report.blocks[0].actions.size());
+    EXPECT_EQ(typeid(Sleep), *report.blocks[0].actions[1].type);
+    EXPECT_EQ(1u, report.blocks[0].actions[1].calls);
+
+    // AND the BlockTuple reports its own executions
+    EXPECT_EQ(2u, blockTuple.Report().blocks[0].calls);
+}
+
+TEST(InstrumentationTest, ReportsTheBranchesTaken) {
+    // GIVEN a chain with an IfThenElse, an IfThen and a TryFallback step
+    ExecutionChain<int&> chain;
+    chain |= If([](const int& a) { return a > 0; }).Then([](int&) {}).Else([](int&) {});
+    chain |= If([](const int& a) { return a > 10; }).Then([](int&) {});
+    chain |= Try([](int& a) { return a > 5; }).Fallback([](int&) { return true; });
+
+    // WHEN executed with 1, 20 and -1
+    for (int value : { 1, 20, -1 }) {
+        chain(value);
+    }
+
+    // THEN each step reports how often each branch was taken
+    const ChainReport report = chain.Report();
+    ASSERT_TRUE(report.blocks[0].branches.has_value());
+    EXPECT_EQ(2u, report.blocks[0].branches->primary);
+    EXPECT_EQ(1u, report.blocks[0].branches->alternative);
+    EXPECT_EQ(1u, report.blocks[1].branches->primary);
+    EXPECT_EQ(2u, report.blocks[1].branches->alternative);
+    EXPECT_EQ(1u, report.blocks[2].branches->primary);
+    EXPECT_EQ(2u, report.blocks[2].branches->alternative);
+
+    // AND the plain actions do not report branches
+    ExecutionChain<int&> plain = Increment{};
+    EXPECT_FALSE(plain.Report().blocks[0].branches.has_value());
+}
+
+} // namespace chain
@@ -0,0 +1,242 @@
+#include "../execution_chain/ExecutionChain.h"
+#include "../execution_chain/ExecutionFlow.h"
+#include "../execution_chain/Memoize.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <barrier>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+struct Point {
+    int x = 0;
+    int y = 0;
+    int result = 0;
+};
+
+} // namespace
+
+TEST(MemoizeTest, SkipsTheComputationWhenTheKeyRepeats) {
+    // GIVEN a memoized computation keyed by x
+    int computations = 0;
+    const auto square = Memoize([](const Point& p) { return p.x; },
+                                [&computations](const Point& p) { ++computations; return p.x * p.x; });
+
+    // WHEN executed twice with the same key
+    Point p{ 3 };
+    EXPECT_EQ(9, square(p));
+    p.y = 5;
+    EXPECT_EQ(9, square(p));
+    // THEN the computation ran once
+    EXPECT_EQ(1, computations);
+
+    // WHEN the key changes
+    p.x = 4;
+    EXPECT_EQ(16, square(p));
+    EXPECT_EQ(2, computations);
+}
+
+TEST(MemoizeTest, AppliesTheCachedResultOnEveryExecution) {
+    // GIVEN a memoized computation applying its result, inside a chain
+    int computations = 0;
+    ExecutionChain<Point&> chain = start_chain
+        | Memoize([](const Point& p) { return p.x; },
+                  [&computations](const Point& p) { ++computations; return p.x * 10; },
+                  [](int result, Point& p) { p.result += result; })
+        | [](Point& p) { ++p.y; };
+
+    // WHEN executed 3 times with the same key
+    Point p{ 2 };
+    for (int i = 0; i < 3; ++i) {
+        chain(p);
+    }
+
+    // THEN the result is applied 3 times, and computed once
+    EXPECT_EQ(60, p.result);
+    EXPECT_EQ(3, p.y);
+    EXPECT_EQ(1, computations);
+}
+
+TEST(MemoizeTest, EvictsTheLeastRecentlyUsedResult) {
+    // GIVEN a LRU cache of 2 results
+    int computations = 0;
+    const auto step = Memoize([](const int& a) { return a; },
+                              [&computations](const int& a) { ++computations; return a + 1; },
+                              MemoizeOptions{ .capacity = 2, .policy = CachePolicy::LeastRecentlyUsed });
+
+    for (int a : { 1, 2, 1, 3 }) {
+        step(a);
+    }
+    // THEN 3 evicted 2, the least recently used
+    EXPECT_EQ(3, computations);
+    int one = 1;
+    step(one);
+    EXPECT_EQ(3, computations);
+    int two = 2;
+    EXPECT_EQ(3, step(two));
+    EXPECT_EQ(4, computations);
+}
+
+TEST(MemoizeTest, DirectMappedReplacesTheEntryOfTheSlot) {
+    // GIVEN a direct-mapped cache of a single slot
+    int computations = 0;
+    const auto step = Memoize([](const int& a) { return a; },
+                              [&computations](const int& a) { ++computations; return a * 2; },
+                              MemoizeOptions{ .capacity = 1 });
+
+    for (int a : { 1, 1, 2, 1 }) {
+        step(a);
+    }
+    // THEN each new key replaced the previous one
+    EXPECT_EQ(3, computations);
+}
+
+TEST(MemoizeTest, IsThePredicateOfAnIf) {
+    // GIVEN a memoized predicate
+    int computations = 0;
+    ExecutionChain<Point&> chain = start_chain
+        | If(Memoize([](const Point& p) { return p.x; },
+                     [&computations](const Point& p) { ++computations; return p.x % 2 == 0; }))
+              .Then([](Point& p) { ++p.result; })
+              .Else([](Point& p) { --p.result; });
+
+    Point even{ 2 };
+    Point odd{ 1 };
+    for (int i = 0; i < 2; ++i) {
+        chain(even);
+        chain(odd);
+    }
+
+    EXPECT_EQ(2, even.result);
+    EXPECT_EQ(-2, odd.result);
+    EXPECT_EQ(2, computations);
+}
+
+TEST(MemoizeTest, ThreadLocalCaches) {
+    // GIVEN a step with a cache per thread
+    std::atomic<int> computations = 0;
+    const auto step = Memoize([](const int& a) { return a % 4; },
+                              [&computations](const int& a) { ++computations; return a % 4; },
+                              MemoizeOptions{ .threadLocal = true });
+
+    // WHEN 4 threads, alive at the same time, execute it with 4 keys
+    std::vector<std::thread> threads;
+    std::atomic<int> sum = 0;
+    std::barrier alive(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            alive.arrive_and_wait();
+            for (int a = 0; a < 100; ++a) {
+                sum += step(a);
+            }
+            // no thread exits, handing its cache over, before the others are done
+            alive.arrive_and_wait();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // THEN each thread computed each key once
+    EXPECT_EQ(4 * 150, sum);
+    EXPECT_EQ(16, computations);
+}
+
+TEST(MemoizeTest, ThreadLocalCachesOutliveTheThreads) {
+    // GIVEN a step with a cache per thread
+    std::atomic<int> computations = 0;
+    const auto step = Memoize([](const int& a) { return a; },
+                              [&computations](const int& a) { ++computations; return a; },
+                              MemoizeOptions{ .threadLocal = true });
+
+    // WHEN more threads than a chunk of caches holds execute it one after the other
+    for (int t = 0; t < 100; ++t) {
+        std::thread([&] { int a = 1; step(a); }).join();
+    }
+
+    // THEN each thread reuses the cache of the thread which exited before it
+    EXPECT_EQ(1, computations);
+}
+
+TEST(MemoizeTest, ClearEmptiesTheCaches) {
+    int computations = 0;
+    auto step = Memoize([](const int& a) { return a; },
+                        [&computations](const int& a) { ++computations; return a; });
+    int a = 1;
+    step(a);
+    step(a);
+    EXPECT_EQ(1, computations);
+
+    // WHEN the cache is cleared
+    step.Clear();
+    // THEN the result is computed again
+    step(a);
+    EXPECT_EQ(2, computations);
+
+    // AND a copy starts with an empty cache
+    const auto copy = step;
+    copy(a);
+    EXPECT_EQ(3, computations);
+}
+
+TEST(MemoizeTest, CopiesOfAChainHaveTheirOwnCaches) {
+    // GIVEN a chain memoizing a computation, whose cache holds a result
+    int computations = 0;
+    const auto step = Memoize([](const Point& p) { return p.x; },
+                              [&computations](const Point& p) { ++computations; return p.x * 10; },
+                              [](int result, Point& p) { p.result = result; });
+    using Step_t = std::decay_t<decltype(step)>;
+    static_assert(!is_shareable_v<Step_t>);
+    ExecutionChain<Point&> chain;
+    chain.append(step);
+    Point p{ 2 };
+    chain(p);
+
+    // WHEN the chain is copied, THEN the copy fills its own cache
+    ExecutionChain<Point&> copy = chain;
+    EXPECT_FALSE(chain.memory_usage().blocks[0].shared);
+    copy(p);
+    copy(p);
+    EXPECT_EQ(2, computations);
+
+    // WHEN the cache of the chain is cleared, THEN the copy keeps its result
+    chain.Visit<Step_t>([](Step_t& memoized) { memoized.Clear(); });
+    copy(p);
+    EXPECT_EQ(2, computations);
+    chain(p);
+    EXPECT_EQ(3, computations);
+    EXPECT_EQ(20, p.result);
+}
+
+TEST(MemoizeTest, KeepsACacheForEachKeyAndResultType) {
+    // GIVEN a memoized generic computation, whose key and result types depend on its argument
+    int computations = 0;
+    const auto twice = Memoize([](const auto& value) { return value; },
+                               [&computations](const auto& value) { ++computations; return value + value; });
+
+    // WHEN it is executed with arguments of different types
+    int number = 2;
+    std::string text = "ab";
+    EXPECT_EQ(4, twice(number));
+    EXPECT_EQ("abab", twice(text));
+
+    // THEN each type has its own cache
+    EXPECT_EQ(4, twice(number));
+    EXPECT_EQ("abab", twice(text));
+    EXPECT_EQ(2, computations);
+
+    // AND clearing the step empties all of them
+    auto copy = twice;
+    copy(number);
+    copy(text);
+    copy.Clear();
+    copy(number);
+    copy(text);
+    EXPECT_EQ(6, computations);
+}
+
+} // namespace chain
@@ -0,0 +1,245 @@
+#include "../execution_chain/ExecutionChain.h"
+#include <array>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+// A stateful action, large enough to be told from the others
+struct Histogram {
+    void operator()(int& value) { ++bins[static_cast<std::size_t>(value) % bins.size()]; }
+    std::array<int, 16> bins{};
+};
+
+struct Increment {
+    void operator()(int& value) const { ++value; }
+};
+
+struct Scale {
+    using shareable = std::true_type;
+    void operator()(int& value) const { value *= factor; }
+    int factor;
+};
+
+// Appends its values to the context : a stateful block, moved by compact
+struct Accumulate {
+    void operator()(std::vector<int>& out) { out.insert(out.end(), values.begin(), values.end()); }
+    std::vector<int> values;
+};
+
+// An immutable block which cannot be copied
+struct MoveOnlyConst {
+    using shareable = std::true_type;
+    void operator()(std::vector<int>& out) const { out.push_back(*value); }
+    std::unique_ptr<int> value;
+};
+
+// An immutable block whose copy throws once armed
+struct ThrowOnCopy {
+    using shareable = std::true_type;
+    explicit ThrowOnCopy(const bool& armed) : armed(&armed) {}
+    ThrowOnCopy(const ThrowOnCopy& other) : armed(other.armed) {
+        if (*armed) {
+            throw std::runtime_error("copy");
+        }
+    }
+    ThrowOnCopy(ThrowOnCopy&&) noexcept = default;
+    void operator()(std::vector<int>& out) const { out.push_back(-1); }
+    const bool* armed;
+};
+
+std::vector<int> run(const ExecutionChain<std::vector<int>&>& chain) {
+    std::vector<int> out;
+    chain.Execute(out);
+    return out;
+}
+
+} // namespace
+
+TEST(MemoryUsageTest, ReportsTheBytesOfEachBlock) {
+    // GIVEN a chain of an immutable block and a stateful one
+    ExecutionChain<int&> chain = start_chain | Increment{};
+    chain.append(Histogram{});
+
+    // WHEN its memory usage is read
+    MemoryUsage usage = chain.memory_usage();
+
+    // THEN each block reports its type and at least the bytes of its action
+    ASSERT_EQ(2u, usage.blocks.size());
+    EXPECT_EQ(0u, usage.blocks[0].index);
+    EXPECT_EQ(1u, usage.blocks[1].index);
+    ASSERT_NE(nullptr, usage.blocks[0].type);
+    ASSERT_NE(nullptr, usage.blocks[1].type);
+    EXPECT_NE(*usage.blocks[0].type, *usage.blocks[1].type);
+    EXPECT_GE(usage.blocks[1].size, sizeof(Histogram));
+    EXPECT_GT(usage.blocks[0].overhead, 0u);
+    EXPECT_FALSE(usage.blocks[0].shared);
+
+    // AND the sums match the blocks, the arena keeping room for the blocks to come
+    EXPECT_EQ(1u, usage.segments);
+    EXPECT_EQ(usage.blocks[0].size + usage.blocks[1].size, usage.actions);
+    EXPECT_GT(usage.slack, 0u);
+    EXPECT_EQ(usage.actions + usage.overhead + usage.slack, usage.total());
+
+    // WHEN the chain is copied, THEN its immutable block is copied along with the stateful one
+    const ExecutionChain<int&> copy = chain;
+    usage = chain.memory_usage();
+    EXPECT_FALSE(usage.blocks[0].shared);
+    EXPECT_FALSE(usage.blocks[1].shared);
+
+    // WHEN an immutable chain is appended and copied, THEN its block is shared
+    const ExecutionChain<int&> increment = start_chain | Increment{};
+    chain.append(increment);
+    const ExecutionChain<int&> other = chain;
+    usage = chain.memory_usage();
+    EXPECT_EQ(2u, usage.segments);
+    EXPECT_TRUE(usage.blocks[2].shared);
+}
+
+TEST(MemoryUsageTest, AlternatingBlocksShareASegment) {
+    // GIVEN a chain alternating immutable and stateful blocks
+    ExecutionChain<int&> chain;
+    for (int i = 0; i < 8; ++i) {
+        chain.append(Increment{});
+        chain.append(Histogram{});
+    }
+
+    // THEN its blocks are stored in a single segment
+    MemoryUsage usage = chain.memory_usage();
+    EXPECT_EQ(16u, usage.blocks.size());
+    EXPECT_EQ(1u, usage.segments);
+
+    // WHEN it is copied and the copy executed, THEN the copy holds its own states
+    ExecutionChain<int&> copy = chain;
+    int value = 0;
+    copy.Execute(value);
+    EXPECT_EQ(8, value);
+    int original = 0;
+    chain.Visit<Histogram>([&](const Histogram& histogram) { original += histogram.bins[1]; });
+    int copied = 0;
+    copy.Visit<Histogram>([&](const Histogram& histogram) { copied += histogram.bins[1]; });
+    EXPECT_EQ(0, original);
+    EXPECT_EQ(1, copied);
+
+    // GIVEN a stateful block followed by an immutable block which cannot be copied
+    ExecutionChain<std::vector<int>&> moveOnly;
+    moveOnly.append(Accumulate{ { 1 } });
+    moveOnly.append(MoveOnlyConst{ std::make_unique<int>(2) });
+
+    // THEN the move-only block keeps its own segment, shared by the copies
+    const ExecutionChain<std::vector<int>&> moveOnlyCopy = moveOnly;
+    usage = moveOnly.memory_usage();
+    EXPECT_EQ(2u, usage.segments);
+    EXPECT_TRUE(usage.blocks[1].shared);
+    EXPECT_EQ((std::vector<int>{ 1, 2 }), run(moveOnlyCopy));
+
+    // AND a single block is allocated to its size, not to the capacity kept for growing arenas
+    const ExecutionChain<int&> single = start_chain | Scale{ 2 };
+    usage = single.memory_usage();
+    EXPECT_LT(usage.slack, sizeof(Histogram));
+}
+
+TEST(MemoryUsageTest, CompactMovesTheBlocksInOneAllocation) {
+    // GIVEN a chain made of the segments of several chains, one of them shared
+    const ExecutionChain<int&> increment = start_chain | Increment{};
+    ExecutionChain<int&> chain = increment;
+    chain.append(Histogram{});
+    chain |= start_chain | Scale{ 3 };
+    chain.append(increment);
+    ASSERT_GT(chain.memory_usage().segments, 1u);
+
+    int before = 4;
+    ExecutionChain<int&> reference = chain;
+    reference.Execute(before);
+
+    // WHEN it is compacted
+    chain.compact();
+
+    // THEN its blocks are in a single segment of their exact size, and none is shared anymore
+    const MemoryUsage usage = chain.memory_usage();
+    EXPECT_EQ(1u, usage.segments);
+    EXPECT_EQ(4u, usage.blocks.size());
+    EXPECT_EQ(0u, usage.slack);
+    for (const BlockMemory& block : usage.blocks) {
+        EXPECT_FALSE(block.shared);
+    }
+
+    // AND it executes as before, the shared chain being left untouched
+    int after = 4;
+    chain.Execute(after);
+    EXPECT_EQ(before, after);
+    int single = 4;
+    increment.Execute(single);
+    EXPECT_EQ(5, single);
+
+    // AND the stateful block moved with its state
+    std::vector<int> states;
+    chain.Visit<Histogram>([&](const Histogram& histogram) { states.push_back(histogram.bins[5]); });
+    EXPECT_EQ((std::vector<int>{ 1 }), states);
+
+    // WHEN a compacted chain is compacted again or extended, THEN it still executes every block
+    chain.compact();
+    EXPECT_EQ(usage.total(), chain.memory_usage().total());
+    chain |= start_chain | Increment{};
+    int extended = 4;
+    chain.Execute(extended);
+    EXPECT_EQ(after + 1, extended);
+}
+
+TEST(MemoryUsageTest, FailedCompactLeavesTheChainUnchanged) {
+    // GIVEN a chain whose stateful block is owned, and whose move-only block is shared with a copy
+    ExecutionChain<std::vector<int>&> chain;
+    chain.append(Accumulate{ { 1, 2 } });
+    chain.append(MoveOnlyConst{ std::make_unique<int>(3) });
+    const ExecutionChain<std::vector<int>&> copy = chain;
+
+    // WHEN it is compacted, THEN the shared block cannot be copied and nothing was moved
+    EXPECT_THROW(chain.compact(), bad_block_copy);
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), run(chain));
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), run(copy));
+
+    // GIVEN a chain whose shared block throws while copied, after an owned block was moved
+    bool armed = false;
+    ExecutionChain<std::vector<int>&> throwing;
+    throwing.append(Accumulate{ { 4, 5 } });
+    const ExecutionChain<std::vector<int>&> sharing = start_chain | ThrowOnCopy(armed);
+    throwing.append(sharing);
+    armed = true;
+
+    // WHEN it is compacted, THEN the moved block is moved back
+    EXPECT_THROW(throwing.compact(), std::runtime_error);
+    EXPECT_EQ((std::vector<int>{ 4, 5, -1 }), run(throwing));
+    EXPECT_EQ(2u, throwing.memory_usage().segments);
+
+    // AND it compacts once its blocks can be copied
+    armed = false;
+    throwing.compact();
+    EXPECT_EQ(1u, throwing.memory_usage().segments);
+    EXPECT_EQ((std::vector<int>{ 4, 5, -1 }), run(throwing));
+}
+
+TEST(MemoryUsageTest, BlockTupleReportsItsActions) {
+    // GIVEN a BlockTuple of an empty action and an action holding a state
+    const auto blockTuple = start_chain | Increment{} | Scale{ 2 };
+
+    // WHEN its memory usage is read
+    const MemoryUsage usage = blockTuple.memory_usage();
+
+    // THEN each action reports its type, the empty one taking no room
+    ASSERT_EQ(2u, usage.blocks.size());
+    EXPECT_EQ(typeid(Increment), *usage.blocks[0].type);
+    EXPECT_EQ(typeid(Scale), *usage.blocks[1].type);
+    EXPECT_EQ(0u, usage.segments);
+    EXPECT_EQ(0u, usage.slack);
+#if !EXECUTION_CHAIN_INSTRUMENTATION
+    EXPECT_EQ(0u, usage.blocks[0].size);
+    EXPECT_EQ(sizeof(Scale), usage.blocks[1].size);
+    EXPECT_EQ(sizeof(blockTuple), usage.total());
+#endif
+}
+
+} // namespace chain
@@ -0,0 +1,132 @@
+#include "../execution_chain/Pipeline.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+TEST(SpscQueueTest, PushAndPopInOrder) {
+    SpscQueue<std::unique_ptr<int>> queue(3);
+    EXPECT_EQ(4u, queue.capacity());
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(std::make_unique<int>(i)));
+    }
+
+    // THEN a full queue rejects the value
+    EXPECT_FALSE(queue.try_push(std::make_unique<int>(4)));
+
+    for (int i = 0; i < 4; ++i) {
+        auto value = queue.try_pop();
+        ASSERT_TRUE(value);
+        EXPECT_EQ(i, **value);
+    }
+    EXPECT_FALSE(queue.try_pop());
+}
+
+TEST(SpscQueueTest, TransfersAcrossThreads) {
+    SpscQueue<int> queue(16);
+    constexpr int count = 100000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < count; ++i) {
+            while (!queue.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int expected = 0; expected < count;) {
+        if (auto value = queue.try_pop()) {
+            ASSERT_EQ(expected, *value);
+            ++expected;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
+
+TEST(PipelineTest, RunsEveryStageInOrder) {
+    struct Message {
+        int value = 0;
+        std::vector<std::thread::id> threads;
+    };
+
+    auto record = [](Message& m) { m.threads.push_back(std::this_thread::get_id()); };
+
+    // GIVEN a pipeline of 3 stages with small queues, to exercise the backpressure
+    Pipeline<Message> pipeline(PipelineOptions{ .queueCapacity = 4, .cores = {}, .collectOutput = true },
+        start_chain | [](Message& m) { m.value += 1; } | record,
+        ExecutionChain<Message&>(start_chain | [](Message& m) { m.value *= 10; } | record),
+        [&](Message& m) { m.value -= 1; record(m); });
+    EXPECT_EQ(3u, pipeline.size());
+
+    // WHEN messages are pushed and popped
+    std::thread consumer([&] {
+        for (int i = 0; i < 1000; ++i) {
+            Message m = pipeline.Pop();
+            ASSERT_EQ(i * 10 + 9, m.value);
+            ASSERT_EQ(3u, m.threads.size());
+            EXPECT_NE(m.threads[0], m.threads[1]);
+            EXPECT_NE(m.threads[1], m.threads[2]);
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        pipeline.Push(Message{ i, {} });
+    }
+
+    // THEN every message goes through the stages, in order
+    pipeline.Drain();
+    consumer.join();
+    EXPECT_FALSE(pipeline.TryPop());
+}
+
+TEST(PipelineTest, ShutdownProcessesTheQueuedContexts) {
+    std::atomic<int> processed{ 0 };
+    {
+        Pipeline<int> pipeline(PipelineOptions{}, [](int& value) { ++value; },
+                               [&](int&) { ++processed; });
+        for (int i = 0; i < 100; ++i) {
+            pipeline.Push(i);
+        }
+        pipeline.Shutdown();
+        EXPECT_EQ(100, processed.load());
+    }
+
+    // AND the destructor of a running pipeline shuts it down
+    {
+        Pipeline<int> pipeline(PipelineOptions{ .queueCapacity = 8, .cores = {}, .collectOutput = false }, [&](int&) { ++processed; });
+        pipeline.TryPush(1);
+    }
+    EXPECT_EQ(101, processed.load());
+}
+
+TEST(PipelineTest, DestroysThePipelineWithUncollectedOutput) {
+    // GIVEN a pipeline collecting its output, whose output queue fills up while nobody pops it
+    std::atomic<int> processed{ 0 };
+    std::optional<int> first;
+    {
+        Pipeline<int> pipeline(PipelineOptions{ .queueCapacity = 2, .cores = {}, .collectOutput = true },
+                               [&](int&) { ++processed; });
+        // 2 contexts in the output, 1 held by the stage waiting for it, 2 in the input of the stage
+        for (int i = 0; i < 5; ++i) {
+            pipeline.Push(i);
+        }
+
+        // WHEN it is shut down, THEN the stage stops waiting for the output and every context is processed
+        pipeline.Shutdown();
+        EXPECT_EQ(5, processed.load());
+
+        // AND the output keeps the contexts it held
+        first = pipeline.TryPop();
+    }
+    EXPECT_EQ(0, first);
+}
+
+} // namespace chain
@@ -0,0 +1,163 @@
+#include "../execution_chain/polymorphic_value.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <memory_resource>
+#include <string>
+
+namespace chain {
+
+namespace {
+
+struct IShape {
+    virtual ~IShape() = default;
+    virtual int area() const = 0;
+};
+
+struct Square : IShape {
+    explicit Square(int side) : side(side) {}
+    int area() const override { return side * side; }
+    int side;
+};
+
+struct BigShape : IShape {
+    int area() const override { return static_cast<int>(payload.size()); }
+    std::array<char, 256> payload{};
+};
+
+template <class PolymorphicValueT>
+bool is_stored_inline(const PolymorphicValueT& pvalue) {
+    const auto* begin = reinterpret_cast<const std::byte*>(&pvalue);
+    const auto* object = reinterpret_cast<const std::byte*>(pvalue.get());
+    return object >= begin && object < begin + sizeof(pvalue);
+}
+
+// Counts the allocations forwarded to the default resource
+struct CountingResource : std::pmr::memory_resource {
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+    int allocations = 0;
+    int deallocations = 0;
+};
+
+} // namespace
+
+TEST(PolymorphicValueTest, DefaultStorageIsOnTheHeap) {
+    polymorphic_value<IShape> pvalue = Square(3);
+    EXPECT_EQ(9, pvalue->area());
+    EXPECT_FALSE(is_stored_inline(pvalue));
+    EXPECT_EQ(sizeof(void*), sizeof(pvalue));
+}
+
+TEST(PolymorphicValueTest, SmallObjectsAreStoredInline) {
+    // GIVEN a polymorphic_value with an inline storage of 32 bytes
+    polymorphic_value<IShape, 32> pvalue = Square(3);
+
+    // THEN the small object is stored inside the polymorphic_value
+    EXPECT_TRUE(is_stored_inline(pvalue));
+    EXPECT_EQ(typeid(Square), pvalue.type());
+
+    // AND its copies and moved values are also stored inline
+    auto copy = pvalue;
+    EXPECT_TRUE(is_stored_inline(copy));
+    EXPECT_EQ(9, copy->area());
+
+    auto moved = std::move(copy);
+    EXPECT_TRUE(is_stored_inline(moved));
+    EXPECT_EQ(9, moved->area());
+    EXPECT_EQ(nullptr, copy);
+
+    // AND the copies are independent
+    static_cast<Square&>(*moved).side = 4;
+    EXPECT_EQ(9, pvalue->area());
+    EXPECT_EQ(16, moved->area());
+}
+
+TEST(PolymorphicValueTest, LargeObjectsFallBackToTheHeap) {
+    polymorphic_value<IShape, 32> pvalue = BigShape();
+    EXPECT_FALSE(is_stored_inline(pvalue));
+    EXPECT_EQ(256, pvalue->area());
+
+    auto copy = pvalue;
+    EXPECT_FALSE(is_stored_inline(copy));
+    EXPECT_EQ(256, copy->area());
+}
+
+TEST(PolymorphicValueTest, SwapMixedStorages) {
+    polymorphic_value<IShape, 32> small = Square(2);
+    polymorphic_value<IShape, 32> big = BigShape();
+
+    small.swap(big);
+    EXPECT_EQ(256, small->area());
+    EXPECT_EQ(4, big->area());
+    EXPECT_TRUE(is_stored_inline(big));
+
+    small = nullptr;
+    EXPECT_EQ(nullptr, small);
+    small = big;
+    EXPECT_EQ(4, small->area());
+}
+
+TEST(PolymorphicValueTest, ConvertsBetweenStorages) {
+    polymorphic_value<Square, 32> square = Square(5);
+    polymorphic_value<IShape> shape(square);
+    EXPECT_EQ(25, shape->area());
+    EXPECT_EQ(typeid(Square), shape.type());
+
+    polymorphic_value<IShape, 64> inlineShape(std::move(square));
+    EXPECT_EQ(25, inlineShape->area());
+    EXPECT_TRUE(is_stored_inline(inlineShape));
+}
+
+TEST(PolymorphicValueTest, NothrowConstructionLeavesTheValueEmptyOnMismatch) {
+    // GIVEN a Square seen through a reference to its base class
+    struct ColoredSquare : Square {
+        using Square::Square;
+        int color = 0;
+    };
+    const ColoredSquare colored(2);
+    const Square& square = colored;
+
+    // THEN its dynamic type does not match, and the value is left empty instead of sliced
+    polymorphic_value<IShape> sliced(std::nothrow, square);
+    EXPECT_FALSE(sliced);
+    EXPECT_THROW(polymorphic_value<IShape>{ square }, bad_polymorphic_value_construction);
+
+    polymorphic_value<IShape> matching(std::nothrow, Square(3));
+    ASSERT_TRUE(matching);
+    EXPECT_EQ(9, matching->area());
+}
+
+TEST(PolymorphicValueTest, AllocatesFromTheMemoryResource) {
+    CountingResource resource;
+    {
+        // GIVEN a value allocated from the resource
+        polymorphic_value<IShape> shape(std::allocator_arg, &resource, BigShape{});
+        EXPECT_EQ(1, resource.allocations);
+        EXPECT_EQ(256, shape->area());
+        EXPECT_EQ(typeid(BigShape), shape.type());
+
+        // THEN its copies are allocated from the same resource
+        polymorphic_value<IShape> copy = shape;
+        EXPECT_EQ(2, resource.allocations);
+        EXPECT_EQ(256, copy->area());
+
+        // AND a small object is still stored inline
+        polymorphic_value<IShape, 32> square(std::allocator_arg, &resource, Square(3));
+        EXPECT_TRUE(is_stored_inline(square));
+        EXPECT_EQ(2, resource.allocations);
+    }
+
+    // AND the memory is given back to the resource
+    EXPECT_EQ(2, resource.deallocations);
+}
+
+} // namespace chain
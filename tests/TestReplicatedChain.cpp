@@ -0,0 +1,71 @@
+#include "../execution_chain/ExecutionFlow.h"
+#include "../execution_chain/ReplicatedChain.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+// stateful : not safe to share between threads
+struct Count {
+    void operator()(int& a) { ++value; a += 1; }
+    long value = 0;
+};
+
+} // namespace
+
+TEST(ReplicatedChainTest, EachExecutionRunsItsOwnReplica) {
+    // GIVEN a replicated chain of stateful actions, with 2 replicas
+    ExecutionChain<int&> prototype;
+    prototype |= Count{};
+    prototype |= Count{};
+    ReplicatedChain<int&> chain(prototype, 2);
+
+    // WHEN 4 threads execute it
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&chain] {
+            for (int i = 0; i < 1000; ++i) {
+                int x = 0;
+                chain(x);
+                EXPECT_EQ(2, x);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // THEN the states of the replicas add up to the executions
+    long total = 0;
+    std::size_t replicas = 0;
+    chain.Merge([&](ExecutionChain<int&>& replica) {
+        ++replicas;
+        replica.Visit<Count>([&](Count& count) { total += count.value; count.value = 0; });
+    });
+    EXPECT_LE(replicas, 2u);
+    EXPECT_EQ(2 * 4000, total);
+
+    // AND the prototype was never executed
+    long executed = 0;
+    chain.Prototype().Visit<Count>([&](const Count& count) { executed += count.value; });
+    EXPECT_EQ(0, executed);
+}
+
+TEST(ReplicatedChainTest, ReplicasAreBuiltOnFirstUse) {
+    ReplicatedChain<int&> chain(start_chain | Try([](int& a) { return ++a > 1; }).Fallback([](int&) { return true; }), 8);
+
+    std::size_t replicas = 0;
+    chain.Merge([&](ExecutionChain<int&>&) { ++replicas; });
+    EXPECT_EQ(0u, replicas);
+
+    int x = 0;
+    EXPECT_TRUE(chain(x));
+    chain.Merge([&](ExecutionChain<int&>&) { ++replicas; });
+    EXPECT_EQ(1u, replicas);
+    EXPECT_EQ(8u, chain.ReplicaCount());
+}
+
+} // namespace chain
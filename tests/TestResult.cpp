@@ -0,0 +1,123 @@
+#include "../execution_chain/ExecutionChain.h"
+#include "../execution_chain/ExecutionFlow.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+enum class ParseError { Empty, TooLong };
+
+Result<ParseError> Parse(const std::string& text) {
+    if (text.empty()) {
+        return Failure{ ParseError::Empty };
+    }
+    if (text.size() > 8) {
+        return Failure{ ParseError::TooLong };
+    }
+    return {};
+}
+
+// A minimal expected value, standing for std::expected<int, std::string>
+struct Parsed {
+    bool has_value() const { return ok; }
+    const std::string& error() const { return message; }
+    bool ok;
+    std::string message;
+};
+
+} // namespace
+
+TEST(ResultTest, FallbackReceivesTheError) {
+    // GIVEN a Try step whose try returns a Result, and a fallback taking the error
+    std::vector<ParseError> handled;
+    auto step = start_chain
+        | Try([](std::string& text) { return Parse(text); })
+            .Fallback([&](const ParseError& error, std::string& text) { handled.push_back(error); text = "default"; });
+
+    // WHEN the try succeeds, THEN the fallback is not called
+    std::string text = "short";
+    EXPECT_TRUE(step(text));
+    EXPECT_TRUE(handled.empty());
+
+    // WHEN it fails, THEN the fallback gets the error
+    text = "";
+    EXPECT_TRUE(step(text));
+    text = "far too long";
+    EXPECT_TRUE(step(text));
+    EXPECT_EQ((std::vector<ParseError>{ ParseError::Empty, ParseError::TooLong }), handled);
+    EXPECT_EQ("default", text);
+
+    // AND a fallback ignoring the error still handles the failure
+    auto ignoring = start_chain | Try([](std::string& t) { return Parse(t); }).Fallback([](std::string& t) { t = "?"; });
+    text = "";
+    EXPECT_TRUE(ignoring(text));
+    EXPECT_EQ("?", text);
+}
+
+TEST(ResultTest, ErrorChannelRecordsTheFailedBlocks) {
+    // GIVEN a chain whose second and fourth blocks may fail
+    ExecutionChain<std::string&> chain;
+    chain |= [](std::string& text) { text += "!"; };
+    chain |= [](std::string& text) { return Parse(text); };
+    chain |= Try([](std::string& text) { return Parse(text); }).Fallback([](std::string&) { return true; });
+    chain |= [](std::string& text) { return Parse(text + text); };
+
+    // WHEN executed with an error channel
+    ErrorChannel<ParseError> errors;
+    std::string text = "0123456";
+    EXPECT_TRUE(chain.Execute(errors, text));
+
+    // THEN only the error of the last block is recorded, the one of the Try step was handled
+    ASSERT_EQ(1u, errors.Errors().size());
+    EXPECT_EQ(3u, errors.Errors()[0].block);
+    EXPECT_EQ(ParseError::TooLong, errors.Errors()[0].error);
+
+    // WHEN executed again, THEN every failure of a RunToEnd chain is recorded
+    errors.Clear();
+    text = "01234567";
+    chain.Execute(errors, text);
+    ASSERT_EQ(2u, errors.Errors().size());
+    EXPECT_EQ(1u, errors.Errors()[0].block);
+    EXPECT_EQ(3u, errors.Errors()[1].block);
+
+    // AND without a channel the errors are dropped
+    chain(text);
+    EXPECT_EQ(2u, errors.Errors().size());
+
+    // AND the actions of a BlockTuple form a single block
+    ExecutionChain<std::string&> tuple = start_chain
+        | [](std::string&) {}
+        | [](std::string& text) { return Parse(text); };
+    errors.Clear();
+    text.clear();
+    tuple.Execute(errors, text);
+    ASSERT_EQ(1u, errors.Errors().size());
+    EXPECT_EQ(0u, errors.Errors()[0].block);
+    EXPECT_EQ(ParseError::Empty, errors.Errors()[0].error);
+}
+
+TEST(ResultTest, ShortCircuitChainStopsAtTheFailedBlock) {
+    int executed = 0;
+    ShortCircuitChain<std::string&> chain = start_chain
+        | [](std::string& text) { return Parsed{ !text.empty(), "empty text" }; }
+        | [&](std::string&) { ++executed; };
+
+    ErrorChannel<std::string> errors;
+    std::string text;
+    EXPECT_FALSE(chain.Execute(errors, text));
+    EXPECT_EQ(0, executed);
+    ASSERT_EQ(1u, errors.Errors().size());
+    EXPECT_EQ(0u, errors.Errors()[0].block);
+    EXPECT_EQ("empty text", errors.Errors()[0].error);
+
+    text = "ok";
+    errors.Clear();
+    EXPECT_TRUE(chain.Execute(errors, text));
+    EXPECT_EQ(1, executed);
+    EXPECT_TRUE(errors.Empty());
+}
+
+} // namespace chain
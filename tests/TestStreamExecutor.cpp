@@ -0,0 +1,125 @@
+#include "../execution_chain/StreamExecutor.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chain {
+
+namespace {
+
+struct Message {
+    Message() { ++constructed; }
+    void Reset() { text.clear(); ++resets; }
+
+    std::string text;
+    int resets = 0;
+    static inline int constructed = 0;
+};
+
+// Reads the inputs one by one into the contexts
+struct Reader {
+    bool operator()(Message& message) {
+        if (next == inputs.size()) {
+            return false;
+        }
+        message.text += inputs[next++];
+        return true;
+    }
+    const std::vector<std::string>& inputs;
+    std::size_t next = 0;
+};
+
+std::vector<std::string> MakeInputs(std::size_t count) {
+    std::vector<std::string> inputs;
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs.push_back(std::to_string(i));
+    }
+    return inputs;
+}
+
+} // namespace
+
+TEST(StreamExecutorTest, RecyclesTheContexts) {
+    // GIVEN a stream executor whose chain appends to the text of the message
+    Message::constructed = 0;
+    StreamExecutor<ExecutionChain<Message&>, Message> executor(start_chain | [](Message& m) { m.text += "!"; }, 4);
+
+    // WHEN it processes 100 inputs
+    const std::vector<std::string> inputs = MakeInputs(100);
+    std::vector<std::string> outputs;
+    EXPECT_EQ(100u, executor.Run(Reader{ inputs }, [&](Message& m) { outputs.push_back(m.text); }));
+
+    // THEN the results reached the sink in order, and a single context was built and reset after each message
+    ASSERT_EQ(100u, outputs.size());
+    EXPECT_EQ("0!", outputs.front());
+    EXPECT_EQ("99!", outputs.back());
+    EXPECT_EQ(1, Message::constructed);
+    EXPECT_EQ(1u, executor.Pool().created());
+
+    // AND the context is reused by the next stream
+    EXPECT_EQ(2u, executor.Run(Reader{ inputs, 98 }, [&](Message& m) { outputs.push_back(m.text); }));
+    EXPECT_EQ("99!", outputs.back());
+    EXPECT_EQ(1, Message::constructed);
+}
+
+TEST(StreamExecutorTest, ThrowingStreamsGiveTheContextsBack) {
+    // GIVEN a stream executor with a single context, whose sink throws
+    StreamExecutor<ExecutionChain<Message&>, Message> executor(start_chain | [](Message& m) { m.text += "!"; }, 1);
+    const std::vector<std::string> inputs = MakeInputs(3);
+    const auto throwing = [](Message&) { throw std::runtime_error("sink"); };
+
+    // WHEN the streams throw, THEN the context is destroyed and its slot is freed
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_THROW(executor.Run(Reader{ inputs }, throwing), std::runtime_error);
+        EXPECT_EQ(0u, executor.Pool().created());
+    }
+    EXPECT_THROW(executor.RunPipelined(PipelineOptions{ .queueCapacity = 4, .cores = {}, .collectOutput = false },
+                                       Reader{ inputs }, throwing, [](Message& m) { m.text += "?"; }),
+                 std::runtime_error);
+
+    // AND the next stream gets a new context
+    std::vector<std::string> outputs;
+    EXPECT_EQ(3u, executor.Run(Reader{ inputs }, [&](Message& m) { outputs.push_back(m.text); }));
+    EXPECT_EQ((std::vector<std::string>{ "0!", "1!", "2!" }), outputs);
+    EXPECT_EQ(1u, executor.Pool().created());
+}
+
+TEST(StreamExecutorTest, ExecutesABlockTupleWithACustomReset) {
+    int resets = 0;
+    auto reset = [&resets](Message& m) { m.text.clear(); ++resets; };
+    auto blockTuple = start_chain | [](Message& m) { m.text += "?"; };
+    StreamExecutor<decltype(blockTuple), Message, decltype(reset)> executor(blockTuple, 2, reset);
+
+    const std::vector<std::string> inputs = MakeInputs(3);
+    std::string concatenated;
+    executor.Run(Reader{ inputs }, [&](const Message& m) { concatenated += m.text; });
+    EXPECT_EQ("0?1?2?", concatenated);
+    // the context read at the end of the stream is reset as well
+    EXPECT_EQ(4, resets);
+}
+
+TEST(StreamExecutorTest, RunPipelinedBoundsTheContextsInFlight) {
+    // GIVEN a stream executor whose chain is followed by 2 stages
+    Message::constructed = 0;
+    StreamExecutor<ExecutionChain<Message&>, Message> executor(start_chain | [](Message& m) { m.text += "a"; }, 8);
+
+    // WHEN 1000 inputs go through the pipeline
+    const std::vector<std::string> inputs = MakeInputs(1000);
+    std::vector<std::string> outputs;
+    const std::size_t processed = executor.RunPipelined(PipelineOptions{ .queueCapacity = 4, .cores = {}, .collectOutput = false },
+                                                        Reader{ inputs },
+                                                        [&](Message& m) { outputs.push_back(m.text); },
+                                                        [](Message& m) { m.text += "b"; },
+                                                        start_chain | [](Message& m) { m.text += "c"; });
+
+    // THEN every input went through the 3 stages in order, on at most 8 contexts
+    EXPECT_EQ(1000u, processed);
+    ASSERT_EQ(1000u, outputs.size());
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+        EXPECT_EQ(inputs[i] + "abc", outputs[i]);
+    }
+    EXPECT_LE(Message::constructed, 8);
+}
+
+} // namespace chain
@@ -0,0 +1,78 @@
+#include "../execution_chain/SwappableChain.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace chain {
+
+TEST(SwappableChainTest, PublishReplacesTheCurrentVersion) {
+    // GIVEN a swappable chain whose first version holds a token
+    auto token = std::make_shared<int>(1);
+    std::weak_ptr<int> observer = token;
+    SwappableChain<int&> chain(start_chain | [token = std::move(token)](int& a) { a += *token; });
+
+    int x = 0;
+    chain(x);
+    EXPECT_EQ(1, x);
+
+    // WHEN a new version is published
+    chain.Publish(start_chain | [](int& a) { a *= 10; });
+
+    // THEN it is executed, and the previous version was destroyed
+    chain(x);
+    EXPECT_EQ(10, x);
+    EXPECT_TRUE(observer.expired());
+
+    // WHEN the current version is updated
+    chain.Update([](ExecutionChain<int&>& next) { next |= [](int& a) { ++a; }; });
+    chain(x);
+    EXPECT_EQ(101, x);
+    EXPECT_EQ(2u, chain.Load().freeze().size());
+}
+
+TEST(SwappableChainTest, PublishWhileExecuting) {
+    // GIVEN a version whose blocks check that they are still alive
+    struct Alive {
+        void operator()(long& a) const { EXPECT_EQ(42, *magic); a += version; }
+        std::shared_ptr<int> magic = std::make_shared<int>(42);
+        long version = 0;
+    };
+    SwappableChain<long&> chain(start_chain | Alive{});
+
+    // WHEN 3 threads execute the chain while the versions are replaced
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> readers;
+    std::atomic<long> executions = 0;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                long value = 0;
+                chain(value);
+                EXPECT_GE(value, 0);
+                ++executions;
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (long version = 1; version <= 200; ++version) {
+        // interleaves the executions and the versions
+        while (executions.load() < version) {
+            std::this_thread::yield();
+        }
+        chain.Publish(start_chain | Alive{ .version = version } | Alive{ .version = version });
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    // THEN the readers only ever executed live versions, and the last one is current
+    long value = 0;
+    chain(value);
+    EXPECT_EQ(400, value);
+    EXPECT_GE(executions.load(), 200);
+}
+
+} // namespace chain
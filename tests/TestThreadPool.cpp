@@ -0,0 +1,177 @@
+#include "../execution_chain/ThreadPool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Fails the next allocation of the current thread once armed
+thread_local bool t_failNextAllocation = false;
+
+} // namespace
+
+// The unaligned allocation functions are replaced together, so that they all allocate with malloc
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    if (t_failNextAllocation) {
+        t_failNextAllocation = false;
+        return nullptr;
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = operator new(size, std::nothrow)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+namespace chain {
+
+TEST(ThreadPoolTest, ParallelForCoversTheWholeRange) {
+    ThreadPool pool(4);
+    std::vector<int> hits(10007, 0);
+
+    pool.ParallelFor(hits.size(), 64, [&](std::size_t begin, std::size_t end) {
+        EXPECT_LE(end - begin, 64u);
+        for (std::size_t i = begin; i < end; ++i) {
+            ++hits[i];
+        }
+    });
+
+    for (int hit : hits) {
+        ASSERT_EQ(1, hit);
+    }
+}
+
+TEST(ThreadPoolTest, ParallelForCanBeNested) {
+    ThreadPool pool(2);
+    std::atomic<int> total{ 0 };
+
+    pool.ParallelFor(8, 1, [&](std::size_t, std::size_t) {
+        pool.ParallelFor(100, 10, [&](std::size_t begin, std::size_t end) {
+            total += static_cast<int>(end - begin);
+        });
+    });
+
+    EXPECT_EQ(800, total);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsExceptions) {
+    ThreadPool pool(2);
+    std::atomic<int> done{ 0 };
+
+    EXPECT_THROW(pool.ParallelFor(16, 1, [&](std::size_t begin, std::size_t) {
+        if (begin == 7) {
+            throw std::runtime_error("chunk 7");
+        }
+        ++done;
+    }), std::runtime_error);
+
+    // every other chunk ran before the exception was rethrown
+    EXPECT_EQ(15, done);
+}
+
+TEST(ThreadPoolTest, ParallelForWaitsForTheQueuedChunksWhenQueuingFails) {
+    std::atomic<int> done{ 0 };
+    int atReturn = 0;
+    {
+        // GIVEN a pool whose queue cannot grow while the chunks are queued
+        ThreadPool pool(1);
+        t_failNextAllocation = true;
+
+        // WHEN a ParallelFor queues more chunks than the queue holds, THEN the allocation failure is rethrown
+        EXPECT_THROW(pool.ParallelFor(1000, 1, [&](std::size_t, std::size_t) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            ++done;
+        }), std::bad_alloc);
+        t_failNextAllocation = false;
+        atReturn = done;
+    }
+
+    // AND every queued chunk was done before it returned, the others were never run
+    EXPECT_GT(atReturn, 0);
+    EXPECT_LT(atReturn, 1000);
+    EXPECT_EQ(atReturn, done);
+}
+
+TEST(ThreadPoolTest, ParallelForReturnsAfterTheLastAccessToItsChunks) {
+    ThreadPool pool(4);
+    std::atomic<int> total{ 0 };
+
+    // the jobs live on the stack of the caller, each returns before the next one reuses it
+    for (int i = 0; i < 2000; ++i) {
+        pool.ParallelFor(5, 1, [&](std::size_t begin, std::size_t end) { total += static_cast<int>(end - begin); });
+    }
+
+    EXPECT_EQ(10000, total);
+}
+
+TEST(ThreadPoolTest, ThreadIndexIsGivenBackWhenTheThreadExits) {
+    // GIVEN the index of a thread which exited
+    std::size_t first = 0;
+    std::thread([&] { first = detail::thread_index(); }).join();
+
+    // WHEN many threads are created one after the other, THEN each takes that index again
+    for (int t = 0; t < 100; ++t) {
+        std::size_t index = 0;
+        std::thread([&] { index = detail::thread_index(); }).join();
+        ASSERT_EQ(first, index);
+    }
+
+    // AND the threads alive at the same time have different indices
+    const std::size_t mine = detail::thread_index();
+    std::size_t other = 0;
+    std::thread([&] { other = detail::thread_index(); }).join();
+    EXPECT_NE(mine, other);
+}
+
+TEST(ThreadPoolTest, SubmitRunsTasksOnWorkers) {
+    ThreadPool pool(2);
+    std::promise<std::thread::id> promise;
+    auto future = promise.get_future();
+
+    pool.Submit([&promise] { promise.set_value(std::this_thread::get_id()); });
+
+    EXPECT_NE(std::this_thread::get_id(), future.get());
+}
+
+} // namespace chain